@@ -5,6 +5,10 @@ The example will prompt the user for whether to capture an image (2D) or a point
 In both instances it will operate on an BGRA image. However, in the 3D case it will extract
 the BGRA image from the point cloud. The 2D variant is faster.
 
+Run with --cache-to-disk to save the intrinsics and undistortion maps to files in the current directory, which later
+runs load instead of querying the camera and building the maps again. Delete the intrinsics files after recalibrating
+the camera or applying an infield correction.
+
 Note: This example uses experimental SDK features, which may be modified, moved, or deleted in the future without notice.
 */
 
@@ -17,7 +21,14 @@ Note: This example uses experimental SDK features, which may be modified, moved,
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
+#include <array>
+#include <cstdint>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
 
 namespace
 {
@@ -154,6 +165,208 @@ namespace
         return cameraIntrinsicsCV;
     }
 
+    // Only the settings that change the image resolution affect the intrinsics
+    std::string configurationKey(const Zivid::Settings &settings)
+    {
+        return "3D_" + settings.sampling().pixel().toString() + "_"
+               + settings.processing().resampling().mode().toString();
+    }
+
+    std::string configurationKey(const Zivid::Settings2D &settings2D)
+    {
+        return "2D_" + settings2D.sampling().pixel().toString();
+    }
+
+    // Queries the intrinsics, or if persistToDisk is set, loads them from a YAML file saved by an earlier run. The
+    // serial number, firmware version and resolution-affecting settings are part of the file name, but a saved file
+    // goes stale after a recalibration or an infield correction of the camera, and must then be deleted.
+    template<typename SettingsType>
+    Zivid::CameraIntrinsics
+        loadOrQueryIntrinsics(const Zivid::Camera &camera, const SettingsType &settings, const bool persistToDisk)
+    {
+        const auto info = camera.info();
+        const auto fileName = "Intrinsics_" + info.serialNumber().toString() + "_" + info.firmwareVersion().toString()
+                              + "_" + configurationKey(settings) + ".yml";
+        if(persistToDisk && std::ifstream(fileName).good())
+        {
+            return Zivid::CameraIntrinsics(fileName);
+        }
+
+        const auto intrinsics = Zivid::Experimental::Calibration::intrinsics(camera, settings);
+        if(persistToDisk)
+        {
+            intrinsics.save(fileName);
+        }
+        return intrinsics;
+    }
+
+    // Fixed-point remap tables (CV_16SC2 and CV_16UC1) for cv::remap
+    struct UndistortionMaps
+    {
+        cv::Mat map1;
+        cv::Mat map2;
+    };
+
+    std::string undistortionMapsFileName(
+        const std::string &serialNumber,
+        const std::string &settingsKey,
+        const cv::Size &size,
+        const double alpha)
+    {
+        const auto alphaKey = alpha < 0 ? std::string{ "original" } : std::to_string(alpha);
+        return "UndistortionMaps_" + serialNumber + "_" + settingsKey + "_" + std::to_string(size.width) + "x"
+               + std::to_string(size.height) + "_" + alphaKey + ".bin";
+    }
+
+    // Stored in the file header, so that maps built from other intrinsics, e.g. before a recalibration, are rebuilt
+    // instead of being used
+    constexpr int32_t undistortionMapsFileVersion = 1;
+
+    std::array<double, 10> undistortionMapsParameters(const CameraIntrinsicsCV &intrinsics, const double alpha)
+    {
+        const auto &k = intrinsics.cameraMatrix;
+        const auto &d = intrinsics.distortionCoefficients;
+        return { { k.at<double>(0, 0),
+                   k.at<double>(1, 1),
+                   k.at<double>(0, 2),
+                   k.at<double>(1, 2),
+                   d.at<double>(0, 0),
+                   d.at<double>(0, 1),
+                   d.at<double>(0, 2),
+                   d.at<double>(0, 3),
+                   d.at<double>(0, 4),
+                   alpha } };
+    }
+
+    bool loadUndistortionMaps(
+        const std::string &fileName,
+        const cv::Size &size,
+        const std::array<double, 10> &parameters,
+        UndistortionMaps &maps)
+    {
+        std::ifstream file(fileName, std::ios::binary);
+        if(!file)
+        {
+            return false;
+        }
+
+        std::array<int32_t, 4> storedHeader{};
+        std::array<double, 10> storedParameters{};
+        file.read(reinterpret_cast<char *>(storedHeader.data()), sizeof(storedHeader));
+        file.read(reinterpret_cast<char *>(storedParameters.data()), sizeof(storedParameters));
+        const std::array<int32_t, 4> header{ { undistortionMapsFileVersion, CV_16SC2, size.width, size.height } };
+        if(!file || storedHeader != header || storedParameters != parameters)
+        {
+            return false;
+        }
+
+        UndistortionMaps loadedMaps{ cv::Mat(size, CV_16SC2), cv::Mat(size, CV_16UC1) };
+        for(const auto &map : { loadedMaps.map1, loadedMaps.map2 })
+        {
+            file.read(reinterpret_cast<char *>(map.data), static_cast<std::streamsize>(map.total() * map.elemSize()));
+        }
+        if(!file)
+        {
+            return false;
+        }
+
+        maps = loadedMaps;
+        return true;
+    }
+
+    void saveUndistortionMaps(
+        const std::string &fileName,
+        const cv::Size &size,
+        const std::array<double, 10> &parameters,
+        const UndistortionMaps &maps)
+    {
+        std::ofstream file(fileName, std::ios::binary);
+        const std::array<int32_t, 4> header{ { undistortionMapsFileVersion, CV_16SC2, size.width, size.height } };
+        file.write(reinterpret_cast<const char *>(header.data()), sizeof(header));
+        file.write(reinterpret_cast<const char *>(parameters.data()), sizeof(parameters));
+        for(const auto &map : { maps.map1, maps.map2 })
+        {
+            file.write(
+                reinterpret_cast<const char *>(map.data), static_cast<std::streamsize>(map.total() * map.elemSize()));
+        }
+        if(!file)
+        {
+            throw std::runtime_error("Failed to save undistortion maps to file: " + fileName);
+        }
+    }
+
+    // Building the undistortion maps costs as much as a full cv::undistort, while applying them with cv::remap is
+    // cheap. The maps are therefore built once per image size and alpha, kept in memory, and optionally saved to disk
+    // with the camera serial number and settings in the file name, so that later runs can load them. Saved maps are
+    // only loaded if the intrinsics and alpha stored with them match the current ones.
+    class UndistortionMapCache
+    {
+    public:
+        UndistortionMapCache(
+            std::string serialNumber,
+            std::string settingsKey,
+            CameraIntrinsicsCV intrinsics,
+            const bool persistToDisk)
+            : mSerialNumber(std::move(serialNumber))
+            , mSettingsKey(std::move(settingsKey))
+            , mIntrinsics(std::move(intrinsics))
+            , mPersistToDisk(persistToDisk)
+        {}
+
+        // Alpha is the free scaling parameter of cv::getOptimalNewCameraMatrix, a negative alpha keeps the original
+        // camera matrix
+        const UndistortionMaps &maps(const cv::Size &size, const double alpha)
+        {
+            const auto key = std::make_tuple(size.width, size.height, alpha);
+            const auto cached = mMaps.find(key);
+            if(cached != mMaps.end())
+            {
+                return cached->second;
+            }
+
+            const auto fileName = undistortionMapsFileName(mSerialNumber, mSettingsKey, size, alpha);
+            const auto parameters = undistortionMapsParameters(mIntrinsics, alpha);
+            UndistortionMaps maps;
+            if(!(mPersistToDisk && loadUndistortionMaps(fileName, size, parameters, maps)))
+            {
+                const auto newCameraMatrix =
+                    alpha < 0 ? mIntrinsics.cameraMatrix
+                              : cv::getOptimalNewCameraMatrix(
+                                  mIntrinsics.cameraMatrix, mIntrinsics.distortionCoefficients, size, alpha, size);
+                cv::initUndistortRectifyMap(
+                    mIntrinsics.cameraMatrix,
+                    mIntrinsics.distortionCoefficients,
+                    cv::Mat(),
+                    newCameraMatrix,
+                    size,
+                    CV_16SC2,
+                    maps.map1,
+                    maps.map2);
+                if(mPersistToDisk)
+                {
+                    saveUndistortionMaps(fileName, size, parameters, maps);
+                }
+            }
+
+            return mMaps.emplace(key, maps).first->second;
+        }
+
+    private:
+        const std::string mSerialNumber;
+        const std::string mSettingsKey;
+        const CameraIntrinsicsCV mIntrinsics;
+        const bool mPersistToDisk;
+        std::map<std::tuple<int, int, double>, UndistortionMaps> mMaps;
+    };
+
+    // Undistorts only the pixels in roi, given in undistorted image coordinates
+    cv::Mat undistort(const cv::Mat &image, const UndistortionMaps &maps, const cv::Rect &roi)
+    {
+        cv::Mat undistorted;
+        cv::remap(image, undistorted, maps.map1(roi), maps.map2(roi), cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+        return undistorted;
+    }
+
     void displayBGR(const cv::Mat &bgr, const std::string &bgrName)
     {
         cv::namedWindow(bgrName, cv::WINDOW_AUTOSIZE);
@@ -162,10 +375,14 @@ namespace
     }
 } // namespace
 
-int main()
+int main(int argc, char **argv)
 {
     try
     {
+        // Saving the intrinsics and undistortion maps lets later runs skip querying and building them, at the cost of
+        // tens of MB per map file
+        const bool cacheToDisk = argc >= 2 && std::string(argv[1]) == "--cache-to-disk";
+
         Zivid::Application zivid;
 
         std::cout << "Connecting to camera" << std::endl;
@@ -191,20 +408,19 @@ int main()
         std::cout << "Undistorting BGR image" << std::endl;
 
         const auto cameraIntrinsticsCV =
-            use2D ? reformatCameraIntrinsics(Zivid::Experimental::Calibration::intrinsics(camera, settings2D))
-                  : reformatCameraIntrinsics(Zivid::Experimental::Calibration::intrinsics(camera, settings));
-        const auto distortionCoefficients = cameraIntrinsticsCV.distortionCoefficients;
-        const auto cameraMatrix = cameraIntrinsticsCV.cameraMatrix;
+            use2D ? reformatCameraIntrinsics(loadOrQueryIntrinsics(camera, settings2D, cacheToDisk))
+                  : reformatCameraIntrinsics(loadOrQueryIntrinsics(camera, settings, cacheToDisk));
 
         const auto size = bgr.size();
-        const auto optimalCameraMatrix =
-            cv::getOptimalNewCameraMatrix(cameraMatrix, distortionCoefficients, size, 1, size);
-
-        cv::Mat bgrUndistorted;
-        cv::Mat bgrUndistortedFull;
+        const auto fullImage = cv::Rect(cv::Point(0, 0), size);
+        UndistortionMapCache undistortionMaps(
+            camera.info().serialNumber().toString(),
+            use2D ? configurationKey(settings2D) : configurationKey(settings),
+            cameraIntrinsticsCV,
+            cacheToDisk);
 
-        cv::undistort(bgr, bgrUndistorted, cameraMatrix, distortionCoefficients);
-        cv::undistort(bgr, bgrUndistortedFull, cameraMatrix, distortionCoefficients, optimalCameraMatrix);
+        const auto bgrUndistorted = undistort(bgr, undistortionMaps.maps(size, -1.0), fullImage);
+        const auto bgrUndistortedFull = undistort(bgr, undistortionMaps.maps(size, 1.0), fullImage);
 
         const auto imageDistortedFile = "ImageDistorted.jpg";
         displayBGR(bgr, "Distorted BGR image");
@@ -220,7 +436,7 @@ int main()
         displayBGR(bgrUndistortedFull, "Undistorted BGR image - full");
         std::cout << "Visualizing and saving undistorted BGR image (full) to file: " << imageUndistortedFull
                   << std::endl;
-        cv::imwrite(imageUndistortedFull, bgrUndistorted);
+        cv::imwrite(imageUndistortedFull, bgrUndistortedFull);
     }
     catch(const std::exception &e)
     {
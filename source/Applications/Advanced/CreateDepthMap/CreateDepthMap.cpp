@@ -14,7 +14,13 @@ ZDF file for this sample can be found under the main instructions for Zivid samp
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <numeric>
+#include <thread>
+#include <vector>
 
 template<>
 struct cv::DataType<Zivid::ColorBGRA>
@@ -30,27 +36,85 @@ struct cv::traits::Type<Zivid::ColorBGRA>
 
 namespace
 {
-    float getValueZ(const Zivid::PointZ &p)
+    // Fixed 1 mm bins covering the working range of all Zivid cameras lets the histogram be filled in a single pass,
+    // without first having to find the min/max Z. Values outside the range are clamped into the edge bins.
+    constexpr float histogramMinZ = 0.F;
+    constexpr float histogramMaxZ = 10000.F;
+    constexpr size_t histogramBins = 10000;
+
+    struct DepthRange
     {
-        return p.z;
-    }
+        float min;
+        float max;
+    };
 
-    bool isLesserOrNan(const Zivid::PointZ &a, const Zivid::PointZ &b)
+    std::vector<uint32_t> depthHistogram(const Zivid::PointZ *points, size_t numberOfPoints)
     {
-        if(std::isnan(getValueZ(a)) && std::isnan(getValueZ(b)))
+        std::vector<uint32_t> histogram(histogramBins, 0);
+        const float binsPerMillimeter = histogramBins / (histogramMaxZ - histogramMinZ);
+        for(size_t i = 0; i < numberOfPoints; i++)
         {
-            return false;
+            const float z = points[i].z;
+            if(!std::isnan(z))
+            {
+                const float bin = std::min(std::max((z - histogramMinZ) * binsPerMillimeter, 0.F), histogramBins - 1.F);
+                histogram[static_cast<size_t>(bin)]++;
+            }
         }
-        return getValueZ(a) < getValueZ(b) ? true : std::isnan(getValueZ(a));
+        return histogram;
     }
 
-    bool isGreaterOrNaN(const Zivid::PointZ &a, const Zivid::PointZ &b)
+    DepthRange robustDepthRange(
+        const Zivid::Array2D<Zivid::PointZ> &points,
+        const float lowerPercentile,
+        const float upperPercentile)
     {
-        if(std::isnan(getValueZ(a)) && std::isnan(getValueZ(b)))
+        // Each thread fills a histogram for its own chunk of the point cloud, and the partial histograms are summed
+        const size_t numberOfThreads = std::max(1U, std::thread::hardware_concurrency());
+        const size_t chunkSize = (points.size() + numberOfThreads - 1) / numberOfThreads;
+        std::vector<std::future<std::vector<uint32_t>>> futureHistograms;
+        for(size_t begin = 0; begin < points.size(); begin += chunkSize)
         {
-            return false;
+            futureHistograms.emplace_back(std::async(
+                std::launch::async, depthHistogram, points.data() + begin, std::min(chunkSize, points.size() - begin)));
+        }
+
+        std::vector<size_t> histogram(histogramBins, 0);
+        for(auto &futureHistogram : futureHistograms)
+        {
+            const auto partialHistogram = futureHistogram.get();
+            std::transform(
+                histogram.begin(), histogram.end(), partialHistogram.begin(), histogram.begin(), std::plus<size_t>());
+        }
+
+        const size_t numberOfValidPoints = std::accumulate(histogram.begin(), histogram.end(), size_t{ 0 });
+        if(numberOfValidPoints == 0)
+        {
+            return DepthRange{ histogramMinZ, histogramMinZ };
+        }
+
+        // Walking the cumulative histogram gives the bins that contain the requested percentiles
+        const auto lowerRank = static_cast<size_t>(lowerPercentile / 100.F * (numberOfValidPoints - 1));
+        const auto upperRank = static_cast<size_t>(upperPercentile / 100.F * (numberOfValidPoints - 1));
+        const float millimetersPerBin = (histogramMaxZ - histogramMinZ) / histogramBins;
+        DepthRange range{ histogramMinZ, histogramMinZ };
+        size_t cumulativeCount = 0;
+        bool lowerFound = false;
+        for(size_t bin = 0; bin < histogramBins; bin++)
+        {
+            cumulativeCount += histogram[bin];
+            if(!lowerFound && cumulativeCount > lowerRank)
+            {
+                range.min = histogramMinZ + bin * millimetersPerBin;
+                lowerFound = true;
+            }
+            if(cumulativeCount > upperRank)
+            {
+                range.max = histogramMinZ + (bin + 1) * millimetersPerBin;
+                break;
+            }
         }
-        return getValueZ(a) > getValueZ(b) ? true : std::isnan(getValueZ(a));
+        return range;
     }
 
     void visualizePointCloud(const Zivid::PointCloud &pointCloud)
@@ -72,9 +136,10 @@ namespace
         cv::Mat z(pointCloud.height(), pointCloud.width(), CV_8UC1, cv::Scalar(0)); // NOLINT(hicpp-signed-bitwise)
         const auto points = pointCloud.copyPointsZ();
 
-        // Getting min and max values for X, Y, Z images
-        const auto *maxZ = std::max_element(points.data(), points.data() + pointCloud.size(), isLesserOrNan);
-        const auto *minZ = std::max_element(points.data(), points.data() + pointCloud.size(), isGreaterOrNaN);
+        // Getting the 1st and 99th percentile of Z, so that a few outliers do not ruin the contrast of the depth map
+        // The range is empty only when there are no valid points, in which case the depth map stays black
+        const auto range = robustDepthRange(points, 1.F, 99.F);
+        const float scale = range.max > range.min ? 255.F / (range.max - range.min) : 0.F;
 
         // Filling in OpenCV matrix with the cloud data
         for(size_t i = 0; i < pointCloud.height(); i++)
@@ -87,8 +152,7 @@ namespace
                 }
                 else
                 {
-                    z.at<uchar>(i, j) =
-                        static_cast<unsigned char>((255.0F * (points(i, j).z - minZ->z) / (maxZ->z - minZ->z)));
+                    z.at<uchar>(i, j) = cv::saturate_cast<uchar>(scale * (points(i, j).z - range.min));
                 }
             }
         }
@@ -7,7 +7,19 @@ The ZDF files for this sample can be found under the main instructions for Zivid
 #include <Zivid/Visualization/Visualizer.h>
 #include <Zivid/Zivid.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace
 {
@@ -25,6 +37,394 @@ namespace
         visualizer.run();
     }
 
+    enum class VoxelSelection
+    {
+        centroid,
+        nearestToCenter
+    };
+
+    struct VoxelKeyAndIndex
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    constexpr int bitsPerVoxelAxis = 21;
+    constexpr uint64_t maxVoxelIndex = (uint64_t{ 1 } << bitsPerVoxelAxis) - 1;
+
+    size_t numberOfWorkers(const size_t numberOfItems)
+    {
+        const size_t minItemsPerWorker = 1 << 16;
+        const size_t maxWorkers = std::max(1U, std::thread::hardware_concurrency());
+        return std::max<size_t>(1, std::min(maxWorkers, numberOfItems / minItemsPerWorker));
+    }
+
+    // Runs function(begin, end) on consecutive chunks of [0, numberOfItems) in parallel
+    template<typename Function>
+    void parallelFor(const size_t numberOfItems, const Function &function)
+    {
+        const auto workers = numberOfWorkers(numberOfItems);
+        const auto chunkSize = (numberOfItems + workers - 1) / workers;
+        std::vector<std::future<void>> futures;
+        for(size_t begin = 0; begin < numberOfItems; begin += chunkSize)
+        {
+            futures.push_back(
+                std::async(std::launch::async, function, begin, std::min(begin + chunkSize, numberOfItems)));
+        }
+        for(auto &future : futures)
+        {
+            future.get();
+        }
+    }
+
+    std::vector<Zivid::PointXYZColorRGBA> validPoints(const Zivid::PointCloud &pointCloud)
+    {
+        std::vector<Zivid::PointXYZColorRGBA> points(pointCloud.size());
+        pointCloud.copyData(points.data());
+        points.erase(
+            std::remove_if(
+                points.begin(),
+                points.end(),
+                [](const Zivid::PointXYZColorRGBA &p) { return std::isnan(p.point.x); }),
+            points.end());
+        return points;
+    }
+
+    Zivid::PointXYZ minimumBound(const std::vector<Zivid::PointXYZColorRGBA> &points)
+    {
+        auto bound = Zivid::PointXYZ{ std::numeric_limits<float>::max(),
+                                      std::numeric_limits<float>::max(),
+                                      std::numeric_limits<float>::max() };
+        for(const auto &p : points)
+        {
+            bound.x = std::min(bound.x, p.point.x);
+            bound.y = std::min(bound.y, p.point.y);
+            bound.z = std::min(bound.z, p.point.z);
+        }
+        return bound;
+    }
+
+    uint64_t voxelIndex(const float coordinate, const float minimum, const float leafSize)
+    {
+        const auto index = static_cast<uint64_t>((coordinate - minimum) / leafSize);
+        if(index > maxVoxelIndex)
+        {
+            throw std::invalid_argument("Voxel leaf size is too small for the extent of the point cloud");
+        }
+        return index;
+    }
+
+    // LSD radix sort on the voxel keys, 8 bits per pass, skipping the passes above the highest key
+    void radixSortByKey(std::vector<VoxelKeyAndIndex> &keys)
+    {
+        uint64_t maxKey = 0;
+        for(const auto &k : keys)
+        {
+            maxKey = std::max(maxKey, k.key);
+        }
+
+        std::vector<VoxelKeyAndIndex> buffer(keys.size());
+        for(int shift = 0; shift < 64 && (maxKey >> shift) != 0; shift += 8)
+        {
+            std::array<size_t, 257> offsets{};
+            for(const auto &k : keys)
+            {
+                offsets[((k.key >> shift) & 0xFF) + 1]++;
+            }
+            for(size_t i = 1; i < offsets.size(); i++)
+            {
+                offsets[i] += offsets[i - 1];
+            }
+            for(const auto &k : keys)
+            {
+                buffer[offsets[(k.key >> shift) & 0xFF]++] = k;
+            }
+            keys.swap(buffer);
+        }
+    }
+
+    Zivid::PointXYZColorRGBA reduceVoxel(
+        const std::vector<Zivid::PointXYZColorRGBA> &points,
+        const std::vector<VoxelKeyAndIndex> &keys,
+        const size_t begin,
+        const size_t end,
+        const Zivid::PointXYZ &voxelCenter,
+        const VoxelSelection selection)
+    {
+        if(selection == VoxelSelection::nearestToCenter)
+        {
+            auto nearest = begin;
+            auto nearestDistance = std::numeric_limits<float>::max();
+            for(size_t i = begin; i < end; i++)
+            {
+                const auto &p = points[keys[i].index].point;
+                const auto dx = p.x - voxelCenter.x;
+                const auto dy = p.y - voxelCenter.y;
+                const auto dz = p.z - voxelCenter.z;
+                const auto distance = dx * dx + dy * dy + dz * dz;
+                if(distance < nearestDistance)
+                {
+                    nearest = i;
+                    nearestDistance = distance;
+                }
+            }
+            return points[keys[nearest].index];
+        }
+
+        std::array<double, 3> pointSum{};
+        std::array<uint32_t, 4> colorSum{};
+        for(size_t i = begin; i < end; i++)
+        {
+            const auto &p = points[keys[i].index];
+            pointSum[0] += p.point.x;
+            pointSum[1] += p.point.y;
+            pointSum[2] += p.point.z;
+            colorSum[0] += p.color.r;
+            colorSum[1] += p.color.g;
+            colorSum[2] += p.color.b;
+            colorSum[3] += p.color.a;
+        }
+        const auto count = static_cast<double>(end - begin);
+        Zivid::PointXYZColorRGBA centroid;
+        centroid.point.x = static_cast<float>(pointSum[0] / count);
+        centroid.point.y = static_cast<float>(pointSum[1] / count);
+        centroid.point.z = static_cast<float>(pointSum[2] / count);
+        centroid.color.r = static_cast<uint8_t>(colorSum[0] / count);
+        centroid.color.g = static_cast<uint8_t>(colorSum[1] / count);
+        centroid.color.b = static_cast<uint8_t>(colorSum[2] / count);
+        centroid.color.a = static_cast<uint8_t>(colorSum[3] / count);
+        return centroid;
+    }
+
+    // Downsamples an unorganized point cloud to one point per occupied voxel. The points are sorted by voxel key, and
+    // each run of equal keys is reduced to its centroid or to the point nearest the voxel center.
+    std::vector<Zivid::PointXYZColorRGBA> voxelDownsample(
+        const std::vector<Zivid::PointXYZColorRGBA> &points,
+        const float leafSize,
+        const VoxelSelection selection)
+    {
+        if(!(leafSize > 0.F))
+        {
+            throw std::invalid_argument("Voxel leaf size must be positive");
+        }
+        if(points.size() > std::numeric_limits<uint32_t>::max())
+        {
+            throw std::invalid_argument("Too many points for voxel downsampling");
+        }
+
+        const auto minimum = minimumBound(points);
+        std::vector<VoxelKeyAndIndex> keys(points.size());
+        parallelFor(points.size(), [&](const size_t begin, const size_t end) {
+            for(size_t i = begin; i < end; i++)
+            {
+                const auto &p = points[i].point;
+                keys[i].key = (voxelIndex(p.z, minimum.z, leafSize) << (2 * bitsPerVoxelAxis))
+                              | (voxelIndex(p.y, minimum.y, leafSize) << bitsPerVoxelAxis)
+                              | voxelIndex(p.x, minimum.x, leafSize);
+                keys[i].index = static_cast<uint32_t>(i);
+            }
+        });
+
+        radixSortByKey(keys);
+
+        // Chunk boundaries are moved forward to the start of a voxel, so that no voxel is split between workers
+        const auto workers = numberOfWorkers(keys.size());
+        std::vector<size_t> boundaries{ 0 };
+        for(size_t worker = 1; worker < workers; worker++)
+        {
+            auto boundary = std::max(boundaries.back(), keys.size() * worker / workers);
+            while(boundary > 0 && boundary < keys.size() && keys[boundary].key == keys[boundary - 1].key)
+            {
+                boundary++;
+            }
+            boundaries.push_back(boundary);
+        }
+        boundaries.push_back(keys.size());
+
+        std::vector<std::future<std::vector<Zivid::PointXYZColorRGBA>>> futures;
+        for(size_t worker = 0; worker + 1 < boundaries.size(); worker++)
+        {
+            futures.push_back(std::async(std::launch::async, [&, worker]() {
+                std::vector<Zivid::PointXYZColorRGBA> voxels;
+                auto begin = boundaries[worker];
+                while(begin < boundaries[worker + 1])
+                {
+                    auto end = begin + 1;
+                    while(end < boundaries[worker + 1] && keys[end].key == keys[begin].key)
+                    {
+                        end++;
+                    }
+                    const auto key = keys[begin].key;
+                    const auto voxelCenter = Zivid::PointXYZ{
+                        minimum.x + (static_cast<float>(key & maxVoxelIndex) + 0.5F) * leafSize,
+                        minimum.y + (static_cast<float>((key >> bitsPerVoxelAxis) & maxVoxelIndex) + 0.5F) * leafSize,
+                        minimum.z + (static_cast<float>(key >> (2 * bitsPerVoxelAxis)) + 0.5F) * leafSize
+                    };
+                    voxels.push_back(reduceVoxel(points, keys, begin, end, voxelCenter, selection));
+                    begin = end;
+                }
+                return voxels;
+            }));
+        }
+
+        std::vector<Zivid::PointXYZColorRGBA> downsampled;
+        for(auto &future : futures)
+        {
+            const auto voxels = future.get();
+            downsampled.insert(downsampled.end(), voxels.begin(), voxels.end());
+        }
+        return downsampled;
+    }
+
+    struct SNRWeightedPointCloud
+    {
+        size_t width;
+        size_t height;
+        std::vector<Zivid::PointXYZColorRGBA> points;
+        std::vector<Zivid::SNR> snrs;
+    };
+
+    // Downsamples an organized point cloud by blockSize x blockSize, where each output point is the mean of the valid
+    // points in its block weighted by SNR squared, i.e. by the inverse of their variance. Points with SNR below minSNR
+    // do not contribute, and blocks without contributors become NaN. The output SNR is the SNR of this weighted mean,
+    // which combines the SNRs of the contributors in quadrature. The block size is a template parameter, so that the
+    // loops over the block have a fixed trip count that the compiler can unroll.
+    template<size_t blockSize>
+    SNRWeightedPointCloud snrWeightedDownsample(
+        const std::vector<Zivid::PointXYZColorRGBA> &points,
+        const std::vector<Zivid::SNR> &snrs,
+        const size_t width,
+        const size_t height,
+        const float minSNR)
+    {
+        SNRWeightedPointCloud downsampled{ width / blockSize, height / blockSize, {}, {} };
+        downsampled.points.resize(downsampled.width * downsampled.height);
+        downsampled.snrs.resize(downsampled.width * downsampled.height);
+
+        parallelFor(downsampled.height, [&](const size_t beginRow, const size_t endRow) {
+            for(size_t row = beginRow; row < endRow; row++)
+            {
+                for(size_t column = 0; column < downsampled.width; column++)
+                {
+                    float weightSum = 0.F;
+                    std::array<float, 3> pointSum{};
+                    std::array<float, 4> colorSum{};
+                    for(size_t blockRow = 0; blockRow < blockSize; blockRow++)
+                    {
+                        const auto offset = (row * blockSize + blockRow) * width + column * blockSize;
+                        for(size_t blockColumn = 0; blockColumn < blockSize; blockColumn++)
+                        {
+                            const auto &p = points[offset + blockColumn];
+                            const auto snr = snrs[offset + blockColumn].value;
+                            // NaN points and points below the threshold do not contribute
+                            if(!std::isnan(p.point.x) && snr >= minSNR)
+                            {
+                                const auto weight = snr * snr;
+                                weightSum += weight;
+                                pointSum[0] += weight * p.point.x;
+                                pointSum[1] += weight * p.point.y;
+                                pointSum[2] += weight * p.point.z;
+                                colorSum[0] += weight * static_cast<float>(p.color.r);
+                                colorSum[1] += weight * static_cast<float>(p.color.g);
+                                colorSum[2] += weight * static_cast<float>(p.color.b);
+                                colorSum[3] += weight * static_cast<float>(p.color.a);
+                            }
+                        }
+                    }
+
+                    auto &output = downsampled.points[row * downsampled.width + column];
+                    auto &outputSNR = downsampled.snrs[row * downsampled.width + column];
+                    if(weightSum > 0.F)
+                    {
+                        output.point.x = pointSum[0] / weightSum;
+                        output.point.y = pointSum[1] / weightSum;
+                        output.point.z = pointSum[2] / weightSum;
+                        output.color.r = static_cast<uint8_t>(colorSum[0] / weightSum + 0.5F);
+                        output.color.g = static_cast<uint8_t>(colorSum[1] / weightSum + 0.5F);
+                        output.color.b = static_cast<uint8_t>(colorSum[2] / weightSum + 0.5F);
+                        output.color.a = static_cast<uint8_t>(colorSum[3] / weightSum + 0.5F);
+                        outputSNR.value = std::sqrt(weightSum);
+                    }
+                    else
+                    {
+                        const auto nan = std::numeric_limits<float>::quiet_NaN();
+                        output.point.x = nan;
+                        output.point.y = nan;
+                        output.point.z = nan;
+                        output.color = Zivid::ColorRGBA{ 0, 0, 0, 0 };
+                        outputSNR.value = 0.F;
+                    }
+                }
+            }
+        });
+
+        return downsampled;
+    }
+
+    SNRWeightedPointCloud snrWeightedDownsample(
+        const Zivid::PointCloud &pointCloud,
+        const size_t blockSize,
+        const float minSNR)
+    {
+        std::vector<Zivid::PointXYZColorRGBA> points(pointCloud.size());
+        pointCloud.copyData(points.data());
+        std::vector<Zivid::SNR> snrs(pointCloud.size());
+        pointCloud.copyData(snrs.data());
+
+        const auto width = pointCloud.width();
+        const auto height = pointCloud.height();
+        switch(blockSize)
+        {
+            case 2: return snrWeightedDownsample<2>(points, snrs, width, height, minSNR);
+            case 3: return snrWeightedDownsample<3>(points, snrs, width, height, minSNR);
+            case 4: return snrWeightedDownsample<4>(points, snrs, width, height, minSNR);
+            default: break;
+        }
+
+        throw std::invalid_argument("Block size must be 2, 3 or 4");
+    }
+
+    // Multi-resolution pyramid of a point cloud, where level n is downsampled by 2^n x 2^n. Each level is computed on
+    // first request from the level above it, and is then cached and shared by all users of the pyramid.
+    class PointCloudPyramid
+    {
+    public:
+        static constexpr size_t numberOfLevels = 4;
+
+        // The pyramid owns a copy of the point cloud, so that in-place changes to the original, which shares its data
+        // with the frame, do not invalidate the cached levels
+        explicit PointCloudPyramid(const Zivid::PointCloud &pointCloud)
+        {
+            mLevels.reserve(numberOfLevels);
+            mLevels.push_back(pointCloud.clone());
+        }
+
+        PointCloudPyramid(const PointCloudPyramid &) = delete;
+        PointCloudPyramid &operator=(const PointCloudPyramid &) = delete;
+
+        const Zivid::PointCloud &level(const size_t level)
+        {
+            if(level >= numberOfLevels)
+            {
+                throw std::out_of_range(
+                    "Pyramid level " + std::to_string(level) + " is out of range, the pyramid has "
+                    + std::to_string(numberOfLevels) + " levels");
+            }
+
+            // The levels never move, since the capacity is reserved up front
+            std::lock_guard<std::mutex> lock(mMutex);
+            while(mLevels.size() <= level)
+            {
+                mLevels.push_back(mLevels.back().downsampled(Zivid::PointCloud::Downsampling::by2x2));
+            }
+            return mLevels[level];
+        }
+
+    private:
+        std::mutex mMutex;
+        std::vector<Zivid::PointCloud> mLevels;
+    };
+
 } // namespace
 
 int main()
@@ -52,6 +452,41 @@ int main()
         std::cout << "Size of point cloud after downsampling: " << downsampledPointCloud.size() << " data points"
                   << std::endl;
 
+        std::cout << "Building a point cloud pyramid" << std::endl;
+        std::cout << "Each level is computed once when first requested, and reused by later requests." << std::endl;
+        PointCloudPyramid pyramid(pointCloud);
+        for(const auto level : std::array<size_t, 4>{ { 3, 1, 2, 0 } })
+        {
+            std::cout << "Size of pyramid level " << level << " (1/" << (1 << level)
+                      << " resolution): " << pyramid.level(level).size() << " data points" << std::endl;
+        }
+
+        std::cout << "Downsampling point cloud with SNR-weighted averaging" << std::endl;
+        std::cout << "Points with low SNR contribute less, and points below the threshold are dropped." << std::endl;
+        const auto minSNR = 5.F;
+        for(const auto blockSize : std::array<size_t, 3>{ { 2, 3, 4 } })
+        {
+            const auto snrWeighted = snrWeightedDownsample(pointCloud, blockSize, minSNR);
+            std::cout << "Size of point cloud after SNR-weighted " << blockSize << "x" << blockSize
+                      << " downsampling: " << snrWeighted.points.size() << " data points" << std::endl;
+        }
+
+        std::cout << "Downsampling the valid points with a voxel grid" << std::endl;
+        std::cout << "This reduces the density of unorganized point clouds, e.g. stitched point clouds." << std::endl;
+        const auto points = validPoints(pointCloud);
+        const auto leafSize = 5.F;
+        for(const auto selection : { VoxelSelection::centroid, VoxelSelection::nearestToCenter })
+        {
+            const auto before = std::chrono::steady_clock::now();
+            const auto voxels = voxelDownsample(points, leafSize, selection);
+            const auto duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - before);
+
+            std::cout << "Voxel downsampling (" << leafSize << " mm, "
+                      << (selection == VoxelSelection::centroid ? "centroid" : "nearest to center") << ") reduced "
+                      << points.size() << " valid points to " << voxels.size() << " points in " << duration.count()
+                      << " ms" << std::endl;
+        }
+
         std::cout << "Downsampling point cloud (in-place)" << std::endl;
         std::cout << "This modifies the current point cloud." << std::endl;
         pointCloud.downsample(Zivid::PointCloud::Downsampling::by2x2);
@@ -1,5 +1,10 @@
 /*
 Capture 2D image with gamma correction.
+
+The image is captured once without gamma correction, and each requested gamma is then applied with a lookup table.
+
+Run with --compare-with-sdk to capture one more image with the first requested gamma applied by the SDK, and check that
+the lookup table result matches it within a tolerance.
 */
 
 #include <Zivid/Zivid.h>
@@ -8,18 +13,83 @@ Capture 2D image with gamma correction.
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
+#include <cmath>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace
 {
-    double readGamma(int argc, char **argv)
+    struct Options
+    {
+        std::vector<double> gammas;
+        bool compareWithSDK;
+    };
+
+    Options readOptions(int argc, char **argv)
     {
-        if(argc < 2)
+        Options options{ {}, false };
+        for(int i = 1; i < argc; i++)
+        {
+            const std::string argument = argv[i];
+            if(argument == "--compare-with-sdk")
+            {
+                options.compareWithSDK = true;
+                continue;
+            }
+
+            size_t parsedLength = 0;
+            double gamma = 0.0;
+            try
+            {
+                gamma = std::stod(argument, &parsedLength);
+            }
+            catch(const std::exception &)
+            {
+                parsedLength = 0;
+            }
+            if(parsedLength != argument.size() || !std::isfinite(gamma) || gamma <= 0.0)
+            {
+                throw std::invalid_argument("Gamma must be a positive number, got: " + argument);
+            }
+            options.gammas.push_back(gamma);
+        }
+
+        if(options.gammas.empty())
         {
             throw std::runtime_error("Gamma is not provided");
         }
+        return options;
+    }
+
+    // The index keeps the names unique for gammas that are equal after rounding
+    std::string adjustedImageFileName(const size_t index, const double gamma)
+    {
+        std::ostringstream fileName;
+        fileName << "Adjusted_" << index << "_" << std::fixed << std::setprecision(2) << gamma << ".jpg";
+        return fileName.str();
+    }
+
+    // Per-channel lookup table with the same tone curve as Settings2D::Processing::Color::Gamma, where
+    // out = 255 * (in / 255)^gamma. The alpha channel is left unchanged.
+    cv::Mat gammaLookupTable(const double gamma)
+    {
+        cv::Mat lookupTable(1, 256, CV_8UC4);
+        for(int i = 0; i < 256; i++)
+        {
+            const auto value = cv::saturate_cast<uchar>(255.0 * std::pow(i / 255.0, gamma));
+            lookupTable.at<cv::Vec4b>(0, i) = cv::Vec4b(value, value, value, static_cast<uchar>(i));
+        }
+        return lookupTable;
+    }
 
-        return std::stod(argv[1]);
+    // Output may be the same cv::Mat as input, in which case the image is corrected in place
+    void applyGamma(const cv::Mat &bgra, cv::Mat &output, const cv::Mat &lookupTable)
+    {
+        cv::LUT(bgra, lookupTable, output);
     }
 
     cv::Mat captureBGRAImage(Zivid::Camera &camera, const double gamma)
@@ -40,6 +110,35 @@ namespace
     }
 
 
+    // The SDK applies gamma before the colors are quantized to 8 bits, and the two images are separate captures with
+    // their own noise, so they are compared by the mean absolute difference per channel
+    void checkDifference(const cv::Mat &lookupTableImage, const cv::Mat &sdkImage)
+    {
+        const double maxMeanDifference = 3.0;
+
+        cv::Mat difference;
+        cv::absdiff(lookupTableImage, sdkImage, difference);
+        const auto meanDifference = cv::mean(difference);
+        double maxDifference = 0.0;
+        cv::minMaxLoc(difference.reshape(1), nullptr, &maxDifference);
+        std::cout << "Difference between lookup table and SDK gamma per channel (B, G, R): mean (" << meanDifference[0]
+                  << ", " << meanDifference[1] << ", " << meanDifference[2] << "), max " << maxDifference
+                  << std::endl;
+
+        for(int channel = 0; channel < 3; channel++)
+        {
+            if(meanDifference[channel] > maxMeanDifference)
+            {
+                throw std::runtime_error(
+                    "Mean difference between lookup table and SDK gamma is above the tolerance of "
+                    + std::to_string(maxMeanDifference));
+            }
+        }
+        std::cout << "The lookup table matches the SDK gamma within the tolerance of " << maxMeanDifference
+                  << std::endl;
+    }
+
+
     cv::Mat combineImages(const cv::Mat &imageOne, const cv::Mat &imageTwo)
     {
         cv::Mat combinedImage;
@@ -69,7 +168,8 @@ int main(int argc, char **argv)
     try
     {
         Zivid::Application zivid;
-        const double gamma = readGamma(argc, argv);
+        const auto options = readOptions(argc, argv);
+        const auto &gammas = options.gammas;
 
         std::cout << "Connecting to camera" << std::endl;
         auto camera = zivid.connectCamera();
@@ -77,13 +177,30 @@ int main(int argc, char **argv)
         std::cout << "Capturing without gamma correction" << std::endl;
         cv::Mat bgraOriginal = captureBGRAImage(camera, 1.0);
         cv::imwrite("Original.jpg", bgraOriginal);
-        std::cout << "Capturing with gamma correction: " << gamma << std::endl;
-        cv::Mat bgraAdjusted = captureBGRAImage(camera, gamma);
-        cv::imwrite("Adjusted.jpg", bgraAdjusted);
 
-        std::cout << "Displaying color image before and after gamma correction: " << gamma << std::endl;
-        cv::Mat combinedImage = combineImages(bgraOriginal, bgraAdjusted);
-        displayBGRA(combinedImage, "Original on left, adjusted on right");
+        cv::Mat bgraSDKAdjusted;
+        if(options.compareWithSDK)
+        {
+            std::cout << "Capturing with gamma correction by the SDK: " << gammas.front() << std::endl;
+            bgraSDKAdjusted = captureBGRAImage(camera, gammas.front());
+        }
+
+        cv::Mat bgraAdjusted;
+        for(size_t i = 0; i < gammas.size(); i++)
+        {
+            const auto gamma = gammas[i];
+            std::cout << "Applying gamma correction to the captured image: " << gamma << std::endl;
+            applyGamma(bgraOriginal, bgraAdjusted, gammaLookupTable(gamma));
+            cv::imwrite(adjustedImageFileName(i, gamma), bgraAdjusted);
+            if(i == 0 && options.compareWithSDK)
+            {
+                checkDifference(bgraAdjusted, bgraSDKAdjusted);
+            }
+
+            std::cout << "Displaying color image before and after gamma correction: " << gamma << std::endl;
+            cv::Mat combinedImage = combineImages(bgraOriginal, bgraAdjusted);
+            displayBGRA(combinedImage, "Original on left, adjusted on right");
+        }
     }
     catch(const std::exception &e)
     {
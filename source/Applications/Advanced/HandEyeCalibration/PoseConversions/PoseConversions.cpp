@@ -5,11 +5,14 @@ Zivid primarily operate with a (4x4) transformation matrix. This example shows h
 convert to and from: AxisAngle, Rotation Vector, Roll-Pitch-Yaw, Quaternion
 
 The convenience functions from this example can be reused in applicable applications. The YAML files for this sample can
-be found under the main instructions for Zivid samples.
+be found under the main instructions for Zivid samples. The conversions between Zivid and Eigen transformation matrices
+are in the PoseEstimation library in source/Utilities.
 */
 
 #include <Zivid/Zivid.h>
 
+#include <PoseEstimation/PoseEstimation.h>
+
 #include <Eigen/Core>
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
@@ -153,34 +156,6 @@ namespace
         const std::string asterixLine = "****************************************************************";
         std::cout << asterixLine << "\n* " << txt << std::endl << asterixLine << std::endl;
     }
-
-    Eigen::Affine3f zividToEigen(const Zivid::Matrix4x4 &zividMatrix)
-    {
-        Eigen::Matrix4f eigenMatrix;
-        for(std::size_t row = 0; row < Zivid::Matrix4x4::rows; row++)
-        {
-            for(std::size_t column = 0; column < Zivid::Matrix4x4::cols; column++)
-            {
-                eigenMatrix(row, column) = zividMatrix(row, column);
-            }
-        }
-        Eigen::Affine3f eigenTransform{ eigenMatrix };
-        return eigenTransform;
-    }
-
-    Zivid::Matrix4x4 eigenToZivid(const Eigen::Affine3f &eigenTransform)
-    {
-        Eigen::Matrix4f eigenMatrix = eigenTransform.matrix();
-        Zivid::Matrix4x4 zividMatrix;
-        for(Eigen::Index row = 0; row < eigenMatrix.rows(); row++)
-        {
-            for(Eigen::Index column = 0; column < eigenMatrix.cols(); column++)
-            {
-                zividMatrix(row, column) = eigenMatrix(row, column);
-            }
-        }
-        return zividMatrix;
-    }
 } // namespace
 
 int main()
@@ -195,7 +170,7 @@ int main()
         printHeader("This example shows conversions to/from Transformation Matrix");
 
         Zivid::Matrix4x4 transformationMatrixZivid(std::string(ZIVID_SAMPLE_DATA_DIR) + "/RobotTransform.yaml");
-        const Eigen::Affine3f transformationMatrix = zividToEigen(transformationMatrixZivid);
+        const Eigen::Affine3f transformationMatrix = PoseEstimation::zividToEigen(transformationMatrixZivid);
         std::cout << transformationMatrix.matrix().format(matrixFormatRules) << std::endl;
 
         // Extract Rotation Matrix and Translation Vector from Transformation Matrix
@@ -235,7 +210,8 @@ int main()
         // Combine Rotation Matrix with Translation Vector to form Transformation Matrix
         Eigen::Affine3f transformationMatrixFromQuaternion(rotationMatrixFromQuaternion);
         transformationMatrixFromQuaternion.translation() = translationVector;
-        Zivid::Matrix4x4 transformationMatrixFromQuaternionZivid = eigenToZivid(transformationMatrixFromQuaternion);
+        Zivid::Matrix4x4 transformationMatrixFromQuaternionZivid =
+            PoseEstimation::eigenToZivid(transformationMatrixFromQuaternion);
         transformationMatrixFromQuaternionZivid.save("RobotTransformOut.yaml");
     }
 
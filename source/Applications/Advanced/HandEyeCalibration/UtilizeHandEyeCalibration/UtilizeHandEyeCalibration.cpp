@@ -24,10 +24,14 @@ Eye-In-Hand:
 For verification, check that the Zivid gem centroid 3D coordinates are the same as above after the transformation.
 
 The YAML files for this sample can be found under the main instructions for Zivid samples.
+
+This sample depends on the PoseEstimation library in source/Utilities.
 */
 
 #include <Zivid/Zivid.h>
 
+#include <PoseEstimation/PoseEstimation.h>
+
 #include <Eigen/Core>
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
@@ -89,34 +93,6 @@ namespace
         }
         return RobotCameraConfiguration::unknown;
     }
-
-    Eigen::Affine3f zividToEigen(const Zivid::Matrix4x4 &zividMatrix)
-    {
-        Eigen::Matrix4f eigenMatrix;
-        for(std::size_t row = 0; row < Zivid::Matrix4x4::rows; row++)
-        {
-            for(std::size_t column = 0; column < Zivid::Matrix4x4::cols; column++)
-            {
-                eigenMatrix(row, column) = zividMatrix(row, column);
-            }
-        }
-        Eigen::Affine3f eigenTransform{ eigenMatrix };
-        return eigenTransform;
-    }
-
-    Zivid::Matrix4x4 eigenToZivid(const Eigen::Affine3f &eigenTransform)
-    {
-        Eigen::Matrix4f eigenMatrix = eigenTransform.matrix();
-        Zivid::Matrix4x4 zividMatrix;
-        for(Eigen::Index row = 0; row < eigenMatrix.rows(); row++)
-        {
-            for(Eigen::Index column = 0; column < eigenMatrix.cols(); column++)
-            {
-                zividMatrix(row, column) = eigenMatrix(row, column);
-            }
-        }
-        return zividMatrix;
-    }
 } // namespace
 
 int main()
@@ -176,8 +152,9 @@ int main()
                         std::string(ZIVID_SAMPLE_DATA_DIR) + robotTransformFile);
 
                     std::cout << "Computing camera pose in robot base reference frame" << std::endl;
-                    transformBaseToCamera = eigenToZivid(
-                        zividToEigen(transformBaseToEndEffector) * zividToEigen(transformEndEffectorToCamera));
+                    transformBaseToCamera = PoseEstimation::eigenToZivid(
+                        PoseEstimation::zividToEigen(transformBaseToEndEffector)
+                        * PoseEstimation::zividToEigen(transformEndEffectorToCamera));
 
                     loopContinue = false;
                     break;
@@ -216,7 +193,8 @@ int main()
                               << pointInCameraFrame.y() << " " << pointInCameraFrame.z() << std::endl;
 
                     // Converting to Eigen matrix for easier computation
-                    const Eigen::Affine3f transformBaseToCameraEigen = zividToEigen(transformBaseToCamera);
+                    const Eigen::Affine3f transformBaseToCameraEigen =
+                        PoseEstimation::zividToEigen(transformBaseToCamera);
 
                     std::cout << "Transforming (picking) point from camera to robot base reference frame" << std::endl;
                     const Eigen::Vector4f pointInBaseFrame = transformBaseToCameraEigen * pointInCameraFrame;
@@ -13,8 +13,17 @@ The ZDF file for this sample can be found under the main instructions for Zivid
 #include <pcl/point_types.h>
 #include <pcl/visualization/cloud_viewer.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
 #include <thread>
+#include <vector>
 
 namespace
 {
@@ -35,35 +44,112 @@ namespace
         }
     }
 
-    cv::Mat pointCloudToCvZ(const pcl::PointCloud<pcl::PointXYZRGB> &pointCloud)
+    // Fixed 1 mm bins covering the working range of all Zivid cameras lets the histogram be filled in a single pass,
+    // without first having to find the min/max Z. Values outside the range are clamped into the edge bins.
+    constexpr float histogramMinZ = 0.F;
+    constexpr float histogramMaxZ = 10000.F;
+    constexpr size_t histogramBins = 10000;
+
+    struct DepthRange
+    {
+        float min;
+        float max;
+    };
+
+    std::vector<uint32_t> depthHistogram(const Zivid::PointXYZColorRGBA *points, size_t numberOfPoints)
     {
-        // Getting min and max values for X, Y, Z images
-        float zMax = -1;
-        float zMin = 1000000;
-        for(size_t i = 0; i < pointCloud.height; i++)
+        std::vector<uint32_t> histogram(histogramBins, 0);
+        const float binsPerMillimeter = histogramBins / (histogramMaxZ - histogramMinZ);
+        for(size_t i = 0; i < numberOfPoints; i++)
+        {
+            const float z = points[i].point.z;
+            if(!std::isnan(z))
+            {
+                const float bin = std::min(std::max((z - histogramMinZ) * binsPerMillimeter, 0.F), histogramBins - 1.F);
+                histogram[static_cast<size_t>(bin)]++;
+            }
+        }
+        return histogram;
+    }
+
+    DepthRange robustDepthRange(
+        const std::vector<Zivid::PointXYZColorRGBA> &data,
+        const float lowerPercentile,
+        const float upperPercentile)
+    {
+        // Each thread fills a histogram for its own chunk of the point cloud, and the partial histograms are summed
+        const size_t numberOfPoints = data.size();
+        const size_t numberOfThreads = std::max(1U, std::thread::hardware_concurrency());
+        const size_t chunkSize = (numberOfPoints + numberOfThreads - 1) / numberOfThreads;
+        std::vector<std::future<std::vector<uint32_t>>> futureHistograms;
+        for(size_t begin = 0; begin < numberOfPoints; begin += chunkSize)
+        {
+            futureHistograms.emplace_back(std::async(
+                std::launch::async,
+                depthHistogram,
+                data.data() + begin,
+                std::min(chunkSize, numberOfPoints - begin)));
+        }
+
+        std::vector<size_t> histogram(histogramBins, 0);
+        for(auto &futureHistogram : futureHistograms)
+        {
+            const auto partialHistogram = futureHistogram.get();
+            std::transform(
+                histogram.begin(), histogram.end(), partialHistogram.begin(), histogram.begin(), std::plus<size_t>());
+        }
+
+        const size_t numberOfValidPoints = std::accumulate(histogram.begin(), histogram.end(), size_t{ 0 });
+        if(numberOfValidPoints == 0)
         {
-            for(size_t j = 0; j < pointCloud.width; j++)
+            return DepthRange{ histogramMinZ, histogramMinZ };
+        }
+
+        // Walking the cumulative histogram gives the bins that contain the requested percentiles
+        const auto lowerRank = static_cast<size_t>(lowerPercentile / 100.F * (numberOfValidPoints - 1));
+        const auto upperRank = static_cast<size_t>(upperPercentile / 100.F * (numberOfValidPoints - 1));
+        const float millimetersPerBin = (histogramMaxZ - histogramMinZ) / histogramBins;
+        DepthRange range{ histogramMinZ, histogramMinZ };
+        size_t cumulativeCount = 0;
+        bool lowerFound = false;
+        for(size_t bin = 0; bin < histogramBins; bin++)
+        {
+            cumulativeCount += histogram[bin];
+            if(!lowerFound && cumulativeCount > lowerRank)
             {
-                zMax = std::max(zMax, pointCloud(j, i).z);
-                zMin = std::min(zMin, pointCloud(j, i).z);
+                range.min = histogramMinZ + bin * millimetersPerBin;
+                lowerFound = true;
+            }
+            if(cumulativeCount > upperRank)
+            {
+                range.max = histogramMinZ + (bin + 1) * millimetersPerBin;
+                break;
             }
         }
+        return range;
+    }
+
+    cv::Mat pointCloudToCvZ(const std::vector<Zivid::PointXYZColorRGBA> &data, const cv::Size &size)
+    {
+        // Getting the 1st and 99th percentile of Z, so that a few outliers do not ruin the contrast of the depth map.
+        // The range is empty only when there are no valid points, in which case the depth map stays black
+        const auto range = robustDepthRange(data, 1.F, 99.F);
+        const float scale = range.max > range.min ? 255.F / (range.max - range.min) : 0.F;
 
         // Filling in OpenCV matrix with the cloud data
-        cv::Mat z(pointCloud.height, pointCloud.width, CV_8UC1, cv::Scalar(0)); // NOLINT(hicpp-signed-bitwise)
-        for(size_t i = 0; i < pointCloud.height; i++)
+        cv::Mat z(size, CV_8UC1, cv::Scalar(0)); // NOLINT(hicpp-signed-bitwise)
+        for(int i = 0; i < size.height; i++)
         {
-            for(size_t j = 0; j < pointCloud.width; j++)
+            for(int j = 0; j < size.width; j++)
             {
-                if(std::isnan(pointCloud(j, i).z))
+                const float pointZ = data[i * size.width + j].point.z;
+                if(std::isnan(pointZ))
                 {
                     z.at<uint8_t>(i, j) = 0;
                 }
                 else
                 {
-                    // If few points are captured resulting in zMin == zMax, this will throw an division-by-zero
-                    // exception.
-                    z.at<uint8_t>(i, j) = static_cast<uint8_t>((255.0F * (pointCloud(j, i).z - zMin) / (zMax - zMin)));
+                    z.at<uint8_t>(i, j) = cv::saturate_cast<uint8_t>(scale * (pointZ - range.min));
                 }
             }
         }
@@ -73,11 +159,11 @@ namespace
         cv::applyColorMap(z, zColorMap, cv::COLORMAP_VIRIDIS);
 
         // Setting invalid points (nan) to black
-        for(size_t i = 0; i < pointCloud.height; i++)
+        for(int i = 0; i < size.height; i++)
         {
-            for(size_t j = 0; j < pointCloud.width; j++)
+            for(int j = 0; j < size.width; j++)
             {
-                if(std::isnan(pointCloud(j, i).z))
+                if(std::isnan(data[i * size.width + j].point.z))
                 {
                     auto &zRGB = zColorMap.at<cv::Vec3b>(i, j);
                     zRGB[0] = 0;
@@ -89,76 +175,222 @@ namespace
         return zColorMap;
     }
 
-    pcl::PointCloud<pcl::PointXYZRGB> maskPointCloud(const Zivid::PointCloud &pointCloud, const cv::Mat &mask)
+    // A run of consecutive masked pixels within a row, covering the columns [begin, end)
+    struct MaskRun
     {
-        const auto data = pointCloud.copyPointsXYZColorsRGBA();
-        const int height = data.height();
-        const int width = data.width();
-
-        // Creating point cloud structure
-        pcl::PointCloud<pcl::PointXYZRGB> maskedPointCloud(width, height);
-        maskedPointCloud.is_dense = false;
-        maskedPointCloud.points.resize(height * width);
+        int row;
+        int begin;
+        int end;
+    };
+
+    // A mask stored as the runs inside its bounding box. Masking then only has to visit the masked pixels, which are
+    // usually few compared to the full frame.
+    struct RunLengthMask
+    {
+        cv::Size size;
+        cv::Rect boundingBox;
+        std::vector<MaskRun> runs;
+    };
 
-        // Copying data points within the mask. Rest is set to NaN
-        for(int i = 0; i < height; i++)
+    RunLengthMask runLengthEncode(const cv::Mat &mask)
+    {
+        RunLengthMask encoded{ mask.size(), cv::boundingRect(mask), {} };
+        const auto &box = encoded.boundingBox;
+        for(int i = box.y; i < box.y + box.height; i++)
         {
-            for(int j = 0; j < width; j++)
+            const auto *row = mask.ptr<uint8_t>(i);
+            int j = box.x;
+            while(j < box.x + box.width)
             {
-                if(mask.at<uint8_t>(i, j) > 0)
+                if(row[j] == 0)
                 {
-                    maskedPointCloud(j, i).r = data(i, j).color.r;
-                    maskedPointCloud(j, i).g = data(i, j).color.g;
-                    maskedPointCloud(j, i).b = data(i, j).color.b;
-                    maskedPointCloud(j, i).x = data(i, j).point.x;
-                    maskedPointCloud(j, i).y = data(i, j).point.y;
-                    maskedPointCloud(j, i).z = data(i, j).point.z;
+                    j++;
+                    continue;
                 }
-                else
+                const int begin = j;
+                while(j < box.x + box.width && row[j] > 0)
                 {
-                    maskedPointCloud(j, i).r = 0;
-                    maskedPointCloud(j, i).g = 0;
-                    maskedPointCloud(j, i).b = 0;
-                    maskedPointCloud(j, i).x = NAN;
-                    maskedPointCloud(j, i).y = NAN;
-                    maskedPointCloud(j, i).z = NAN;
+                    j++;
                 }
+                encoded.runs.push_back(MaskRun{ i, begin, j });
             }
         }
+        return encoded;
+    }
 
-        return maskedPointCloud;
+    RunLengthMask runLengthEncode(const std::vector<cv::Point> &polygon, const cv::Size &size)
+    {
+        // Only the bounding box of the polygon is rasterized, so a small region is cheap to encode also for large
+        // frames. Rectangles are passed as their four corners.
+        const auto boundingBox = cv::boundingRect(polygon) & cv::Rect(cv::Point(0, 0), size);
+        cv::Mat boundingBoxMask = cv::Mat::zeros(boundingBox.size(), CV_8U);
+        cv::fillPoly(
+            boundingBoxMask,
+            std::vector<std::vector<cv::Point>>{ polygon },
+            cv::Scalar(255),
+            cv::LINE_8,
+            0,
+            -boundingBox.tl());
+
+        auto encoded = runLengthEncode(boundingBoxMask);
+        encoded.size = size;
+        encoded.boundingBox += boundingBox.tl();
+        for(auto &run : encoded.runs)
+        {
+            run.row += boundingBox.y;
+            run.begin += boundingBox.x;
+            run.end += boundingBox.x;
+        }
+        return encoded;
     }
 
-    void visualizeDepthMap(const pcl::PointCloud<pcl::PointXYZRGB> &pointCloud)
+    // Sets all points outside the mask to NaN, directly in the buffer the point cloud was copied into
+    void maskPointCloud(std::vector<Zivid::PointXYZColorRGBA> &data, const RunLengthMask &mask)
+    {
+        const int width = mask.size.width;
+        const int height = mask.size.height;
+        if(data.size() != static_cast<size_t>(mask.size.area()))
+        {
+            throw std::invalid_argument("Mask size does not match point cloud resolution");
+        }
+
+        // Gaps between the runs are filled by copying from a template row of invalid points
+        Zivid::PointXYZColorRGBA invalidPoint{};
+        invalidPoint.point.x = NAN;
+        invalidPoint.point.y = NAN;
+        invalidPoint.point.z = NAN;
+        const std::vector<Zivid::PointXYZColorRGBA> invalidRow(width, invalidPoint);
+
+        auto run = mask.runs.begin();
+        for(int i = 0; i < height; i++)
+        {
+            auto *row = data.data() + i * width;
+            int column = 0;
+            for(; run != mask.runs.end() && run->row == i; ++run)
+            {
+                std::copy(invalidRow.begin(), invalidRow.begin() + (run->begin - column), row + column);
+                column = run->end;
+            }
+            std::copy(invalidRow.begin(), invalidRow.begin() + (width - column), row + column);
+        }
+    }
+
+    // Extracts the valid points within the mask, without allocating or traversing a full frame
+    std::vector<Zivid::PointXYZColorRGBA> compactMaskedPoints(
+        const std::vector<Zivid::PointXYZColorRGBA> &data,
+        const RunLengthMask &mask)
+    {
+        size_t numberOfMaskedPixels = 0;
+        for(const auto &run : mask.runs)
+        {
+            numberOfMaskedPixels += run.end - run.begin;
+        }
+
+        std::vector<Zivid::PointXYZColorRGBA> maskedPoints;
+        maskedPoints.reserve(numberOfMaskedPixels);
+        for(const auto &run : mask.runs)
+        {
+            const auto *row = data.data() + run.row * mask.size.width;
+            std::copy_if(
+                row + run.begin,
+                row + run.end,
+                std::back_inserter(maskedPoints),
+                [](const Zivid::PointXYZColorRGBA &point) { return !std::isnan(point.point.z); });
+        }
+        return maskedPoints;
+    }
+
+    // Rasterizes each region into a label image, where region i gets label i + 1 and the background is 0
+    cv::Mat labelImage(const std::vector<std::vector<cv::Point>> &regions, const cv::Size &size)
+    {
+        if(regions.size() > 255)
+        {
+            throw std::invalid_argument("At most 255 regions are supported by an 8-bit label image");
+        }
+        cv::Mat labels = cv::Mat::zeros(size, CV_8U);
+        for(size_t i = 0; i < regions.size(); i++)
+        {
+            const auto label = cv::Scalar(static_cast<double>(i + 1));
+            cv::fillPoly(labels, std::vector<std::vector<cv::Point>>{ regions[i] }, label);
+        }
+        return labels;
+    }
+
+    // Splits the valid points into one output per label in a single traversal of the point cloud. Only the bounding
+    // box of the labeled pixels is visited, and the output buffers are allocated up front from the label counts.
+    std::vector<std::vector<Zivid::PointXYZColorRGBA>> splitByLabels(
+        const std::vector<Zivid::PointXYZColorRGBA> &data,
+        const cv::Mat &labels,
+        const size_t numberOfLabels)
+    {
+        if(data.size() != labels.total())
+        {
+            throw std::invalid_argument("Label image size does not match point cloud resolution");
+        }
+
+        const auto boundingBox = cv::boundingRect(labels);
+        std::vector<size_t> labelCounts(numberOfLabels + 1, 0);
+        for(int i = boundingBox.y; i < boundingBox.y + boundingBox.height; i++)
+        {
+            const auto *labelRow = labels.ptr<uint8_t>(i);
+            for(int j = boundingBox.x; j < boundingBox.x + boundingBox.width; j++)
+            {
+                labelCounts[std::min<size_t>(labelRow[j], numberOfLabels)]++;
+            }
+        }
+
+        std::vector<std::vector<Zivid::PointXYZColorRGBA>> labeledPoints(numberOfLabels);
+        for(size_t label = 0; label < numberOfLabels; label++)
+        {
+            labeledPoints[label].reserve(labelCounts[label + 1]);
+        }
+
+        for(int i = boundingBox.y; i < boundingBox.y + boundingBox.height; i++)
+        {
+            const auto *labelRow = labels.ptr<uint8_t>(i);
+            const auto *row = data.data() + i * labels.cols;
+            for(int j = boundingBox.x; j < boundingBox.x + boundingBox.width; j++)
+            {
+                const uint8_t label = labelRow[j];
+                if(label > 0 && label <= numberOfLabels && !std::isnan(row[j].point.z))
+                {
+                    labeledPoints[label - 1].push_back(row[j]);
+                }
+            }
+        }
+        return labeledPoints;
+    }
+
+    void visualizeDepthMap(const std::vector<Zivid::PointXYZColorRGBA> &data, const cv::Size &size)
     {
         // Converting to Depth map in OpenCV format
-        cv::Mat zColorMap = pointCloudToCvZ(pointCloud);
+        cv::Mat zColorMap = pointCloudToCvZ(data, size);
         // Visualizing Depth map
         cv::namedWindow("Depth map", cv::WINDOW_AUTOSIZE);
         cv::imshow("Depth map", zColorMap);
         cv::waitKey(0);
     }
 
-    pcl::PointCloud<pcl::PointXYZRGB> convertToPCLPointCloud(const Zivid::PointCloud &pointCloud)
+    pcl::PointCloud<pcl::PointXYZRGB> convertToPCLPointCloud(
+        const std::vector<Zivid::PointXYZColorRGBA> &data,
+        const cv::Size &size)
     {
-        const auto data = pointCloud.copyData<Zivid::PointXYZColorRGBA>();
-
         // Creating PCL point cloud structure
         pcl::PointCloud<pcl::PointXYZRGB> pointCloudPCL;
-        pointCloudPCL.width = pointCloud.width();
-        pointCloudPCL.height = pointCloud.height();
+        pointCloudPCL.width = size.width;
+        pointCloudPCL.height = size.height;
         pointCloudPCL.is_dense = false;
         pointCloudPCL.points.resize(pointCloudPCL.width * pointCloudPCL.height);
 
         // Filling in point cloud data
         for(size_t i = 0; i < pointCloudPCL.points.size(); ++i)
         {
-            pointCloudPCL.points[i].x = data(i).point.x; // NOLINT(cppcoreguidelines-pro-type-union-access)
-            pointCloudPCL.points[i].y = data(i).point.y; // NOLINT(cppcoreguidelines-pro-type-union-access)
-            pointCloudPCL.points[i].z = data(i).point.z; // NOLINT(cppcoreguidelines-pro-type-union-access)
-            pointCloudPCL.points[i].r = data(i).color.r; // NOLINT(cppcoreguidelines-pro-type-union-access)
-            pointCloudPCL.points[i].g = data(i).color.g; // NOLINT(cppcoreguidelines-pro-type-union-access)
-            pointCloudPCL.points[i].b = data(i).color.b; // NOLINT(cppcoreguidelines-pro-type-union-access)
+            pointCloudPCL.points[i].x = data[i].point.x; // NOLINT(cppcoreguidelines-pro-type-union-access)
+            pointCloudPCL.points[i].y = data[i].point.y; // NOLINT(cppcoreguidelines-pro-type-union-access)
+            pointCloudPCL.points[i].z = data[i].point.z; // NOLINT(cppcoreguidelines-pro-type-union-access)
+            pointCloudPCL.points[i].r = data[i].color.r; // NOLINT(cppcoreguidelines-pro-type-union-access)
+            pointCloudPCL.points[i].g = data[i].color.g; // NOLINT(cppcoreguidelines-pro-type-union-access)
+            pointCloudPCL.points[i].b = data[i].color.b; // NOLINT(cppcoreguidelines-pro-type-union-access)
         }
         return pointCloudPCL;
     }
@@ -179,7 +411,7 @@ int main()
         const auto pointCloud = frame.pointCloud();
 
         const int pixelsToDisplay = 300;
-        std::cout << "Generating binary mask of central " << pixelsToDisplay << " x " << pixelsToDisplay << "pixels."
+        std::cout << "Generating mask of central " << pixelsToDisplay << " x " << pixelsToDisplay << " pixels."
                   << std::endl;
         const int height = pointCloud.height();
         const int width = pointCloud.width();
@@ -187,31 +419,56 @@ int main()
         const int heightMax = (height + pixelsToDisplay) / 2;
         const int widthMin = (width - pixelsToDisplay) / 2;
         const int widthMax = (width + pixelsToDisplay) / 2;
-        cv::Mat mask = cv::Mat::zeros(height, width, CV_8U);
-        cv::rectangle(
-            mask,
-            cv::Point(widthMin, heightMin),
-            cv::Point(widthMax, heightMax),
-            cv::Scalar(255, 255, 255),
-            cv::FILLED);
+        const std::vector<cv::Point> maskPolygon{ cv::Point(widthMin, heightMin),
+                                                  cv::Point(widthMax, heightMin),
+                                                  cv::Point(widthMax, heightMax),
+                                                  cv::Point(widthMin, heightMax) };
+        const auto mask = runLengthEncode(maskPolygon, cv::Size(width, height));
+
+        // The point cloud is copied once into a buffer that is masked in place, since Zivid::Array2D is read-only
+        std::cout << "Copying point cloud data" << std::endl;
+        std::vector<Zivid::PointXYZColorRGBA> data(pointCloud.size());
+        pointCloud.copyData(data.data());
 
         std::cout << "Converting to PCL point cloud" << std::endl;
-        const auto pointCloudPCL = convertToPCLPointCloud(pointCloud);
+        const auto pointCloudPCL = convertToPCLPointCloud(data, mask.size);
 
         std::cout << "Displaying point cloud before masking" << std::endl;
         visualizePointCloud(pointCloudPCL.makeShared());
 
         std::cout << "Displaying depth map before masking" << std::endl;
-        visualizeDepthMap(pointCloudPCL);
+        visualizeDepthMap(data, mask.size);
+
+        std::cout << "Splitting point cloud into the left and right half of the mask" << std::endl;
+        const std::vector<std::vector<cv::Point>> regions{
+            { cv::Point(widthMin, heightMin),
+              cv::Point(width / 2, heightMin),
+              cv::Point(width / 2, heightMax),
+              cv::Point(widthMin, heightMax) },
+            { cv::Point(width / 2 + 1, heightMin),
+              cv::Point(widthMax, heightMin),
+              cv::Point(widthMax, heightMax),
+              cv::Point(width / 2 + 1, heightMax) }
+        };
+        const auto regionPoints = splitByLabels(data, labelImage(regions, mask.size), regions.size());
+        for(size_t i = 0; i < regionPoints.size(); i++)
+        {
+            std::cout << "Region " << i << ": " << regionPoints[i].size() << " valid points" << std::endl;
+        }
 
         std::cout << "Masking point cloud" << std::endl;
-        const pcl::PointCloud<pcl::PointXYZRGB> maskedPointCloudPCL = maskPointCloud(pointCloud, mask);
+        const auto maskedPoints = compactMaskedPoints(data, mask);
+        maskPointCloud(data, mask);
+
+        std::cout << "Converting " << maskedPoints.size() << " valid masked points to PCL point cloud" << std::endl;
+        const auto maskedPointCloudPCL =
+            convertToPCLPointCloud(maskedPoints, cv::Size(static_cast<int>(maskedPoints.size()), 1));
 
         std::cout << "Displaying point cloud after masking" << std::endl;
         visualizePointCloud(maskedPointCloudPCL.makeShared());
 
         std::cout << "Displaying depth map after masking" << std::endl;
-        visualizeDepthMap(maskedPointCloudPCL);
+        visualizeDepthMap(data, mask.size);
     }
 
     catch(const std::exception &e)
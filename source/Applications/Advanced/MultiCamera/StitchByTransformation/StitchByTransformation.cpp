@@ -1,19 +1,26 @@
 /*
 Use transformation matrices from Multi-Camera calibration to transform point clouds into single coordinate frame, from connected cameras.
-
-Note: This example uses experimental SDK features, which may be modified, moved, or deleted in the future without notice.
 */
 
-#include <pcl/io/pcd_io.h>
-#include <pcl/io/ply_io.h>
 #include <pcl/visualization/cloud_viewer.h>
 
 #include <clipp.h>
 
-#include <Zivid/Experimental/SettingsInfo.h>
 #include <Zivid/Zivid.h>
+
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace
@@ -106,6 +113,499 @@ namespace
         0xF13A13, // Vivid Reddish Orange
         0x7F180D, // Strong Reddish Brown
     };
+
+    enum class MergePolicy
+    {
+        first,
+        average,
+        highestSNR
+    };
+
+    // Merges points that fall into the same voxel, using an open-addressing hash table keyed on the voxel index. The
+    // table only stores occupied voxels and grows as they are added, so memory is bounded by the number of voxels.
+    // Ties are broken by the lowest camera index, so the result does not depend on the order the cameras are added in.
+    class VoxelHashMerger
+    {
+    public:
+        VoxelHashMerger(const float voxelSize, const MergePolicy policy)
+            : mVoxelSize{ voxelSize }
+            , mPolicy{ policy }
+            , mVoxels(1U << 16U)
+        {}
+
+        void add(
+            const Zivid::PointXYZ &point,
+            const Zivid::ColorRGBA &color,
+            const float snr,
+            const std::uint32_t cameraIndex)
+        {
+            if(2 * (mNumberOfVoxels + 1) > mVoxels.size())
+            {
+                grow();
+            }
+
+            const auto key = voxelKey(point);
+            auto &voxel = findSlot(mVoxels, key);
+            if(voxel.count == 0)
+            {
+                setVoxel(voxel, key, point, color, snr, cameraIndex);
+                mNumberOfVoxels++;
+            }
+            else if(mPolicy == MergePolicy::first && cameraIndex < voxel.cameraIndex)
+            {
+                setVoxel(voxel, key, point, color, snr, cameraIndex);
+            }
+            else if(mPolicy == MergePolicy::average)
+            {
+                voxel.x += point.x;
+                voxel.y += point.y;
+                voxel.z += point.z;
+                voxel.r += color.r;
+                voxel.g += color.g;
+                voxel.b += color.b;
+                voxel.snr += snr;
+                voxel.count++;
+            }
+            else if(
+                mPolicy == MergePolicy::highestSNR
+                && (snr > voxel.snr || (snr >= voxel.snr && cameraIndex < voxel.cameraIndex)))
+            {
+                setVoxel(voxel, key, point, color, snr, cameraIndex);
+            }
+        }
+
+        pcl::PointCloud<pcl::PointXYZRGB> pointCloud() const
+        {
+            pcl::PointCloud<pcl::PointXYZRGB> mergedPointCloud;
+            mergedPointCloud.points.reserve(mNumberOfVoxels);
+            for(const auto &voxel : mVoxels)
+            {
+                if(voxel.count > 0)
+                {
+                    const float weight = 1.F / voxel.count;
+                    pcl::PointXYZRGB point;
+                    point.x = voxel.x * weight;
+                    point.y = voxel.y * weight;
+                    point.z = voxel.z * weight;
+                    point.r = static_cast<std::uint8_t>(std::lround(voxel.r * weight));
+                    point.g = static_cast<std::uint8_t>(std::lround(voxel.g * weight));
+                    point.b = static_cast<std::uint8_t>(std::lround(voxel.b * weight));
+                    mergedPointCloud.points.push_back(point);
+                }
+            }
+            mergedPointCloud.width = mergedPointCloud.points.size();
+            mergedPointCloud.height = 1;
+            mergedPointCloud.is_dense = true;
+            return mergedPointCloud;
+        }
+
+        // The SNR of each point in pointCloud(), in the same order
+        std::vector<float> snrs() const
+        {
+            std::vector<float> mergedSNRs;
+            mergedSNRs.reserve(mNumberOfVoxels);
+            for(const auto &voxel : mVoxels)
+            {
+                if(voxel.count > 0)
+                {
+                    mergedSNRs.push_back(voxel.snr / voxel.count);
+                }
+            }
+            return mergedSNRs;
+        }
+
+    private:
+        struct Voxel
+        {
+            std::uint64_t key;
+            float x;
+            float y;
+            float z;
+            float r;
+            float g;
+            float b;
+            float snr;
+            std::uint32_t cameraIndex;
+            std::uint32_t count;
+        };
+
+        static void setVoxel(
+            Voxel &voxel,
+            const std::uint64_t key,
+            const Zivid::PointXYZ &point,
+            const Zivid::ColorRGBA &color,
+            const float snr,
+            const std::uint32_t cameraIndex)
+        {
+            voxel.key = key;
+            voxel.x = point.x;
+            voxel.y = point.y;
+            voxel.z = point.z;
+            voxel.r = color.r;
+            voxel.g = color.g;
+            voxel.b = color.b;
+            voxel.snr = snr;
+            voxel.cameraIndex = cameraIndex;
+            voxel.count = 1;
+        }
+
+        std::uint64_t voxelIndex(const float value) const
+        {
+            // 21 bits per axis covers a million voxels in each direction
+            return static_cast<std::uint64_t>(static_cast<std::int64_t>(std::floor(value / mVoxelSize))) & 0x1FFFFFU;
+        }
+
+        std::uint64_t voxelKey(const Zivid::PointXYZ &point) const
+        {
+            return voxelIndex(point.x) | (voxelIndex(point.y) << 21U) | (voxelIndex(point.z) << 42U);
+        }
+
+        static std::uint64_t hash(std::uint64_t key)
+        {
+            // Finalizer of MurmurHash3, which spreads neighbouring voxel keys over the whole table
+            key ^= key >> 33U;
+            key *= 0xff51afd7ed558ccdULL;
+            key ^= key >> 33U;
+            key *= 0xc4ceb9fe1a85ec53ULL;
+            key ^= key >> 33U;
+            return key;
+        }
+
+        static Voxel &findSlot(std::vector<Voxel> &voxels, const std::uint64_t key)
+        {
+            // The table size is a power of two, and linear probing stops at the voxel or the first empty slot
+            const size_t mask = voxels.size() - 1;
+            size_t slot = hash(key) & mask;
+            while(voxels[slot].count > 0 && voxels[slot].key != key)
+            {
+                slot = (slot + 1) & mask;
+            }
+            return voxels[slot];
+        }
+
+        void grow()
+        {
+            std::vector<Voxel> voxels(2 * mVoxels.size());
+            for(const auto &voxel : mVoxels)
+            {
+                if(voxel.count > 0)
+                {
+                    findSlot(voxels, voxel.key) = voxel;
+                }
+            }
+            mVoxels.swap(voxels);
+        }
+
+        const float mVoxelSize;
+        const MergePolicy mPolicy;
+        std::vector<Voxel> mVoxels;
+        size_t mNumberOfVoxels = 0;
+    };
+
+    struct TransformedPoints
+    {
+        Zivid::Array2D<Zivid::PointXYZColorRGBA> data;
+        std::vector<Zivid::SNR> snrs;
+        size_t numberOfValidPoints;
+    };
+
+    TransformedPoints transformAndCopy(
+        const Zivid::Frame &frame,
+        const Zivid::Matrix4x4 &transformationMatrix,
+        const bool copySNRs)
+    {
+        auto pointCloud = frame.pointCloud();
+        pointCloud.transform(transformationMatrix);
+
+        // Copying points and colors together in a single copy
+        auto data = pointCloud.copyData<Zivid::PointXYZColorRGBA>();
+        const auto numberOfValidPoints = std::count_if(
+            data.begin(), data.end(), [](const Zivid::PointXYZColorRGBA &p) { return !std::isnan(p.point.x); });
+
+        std::vector<Zivid::SNR> snrs;
+        if(copySNRs)
+        {
+            snrs.resize(pointCloud.size());
+            pointCloud.copyData(snrs.data());
+        }
+
+        return TransformedPoints{ std::move(data), std::move(snrs), static_cast<size_t>(numberOfValidPoints) };
+    }
+
+    Zivid::ColorRGBA pointColor(const Zivid::ColorRGBA &color, const bool useRGB, const size_t cameraIndex)
+    {
+        if(useRGB)
+        {
+            return color;
+        }
+        const auto rgb = rgbList.at(cameraIndex % rgbList.size());
+        Zivid::ColorRGBA uniformColor{};
+        uniformColor.r = static_cast<std::uint8_t>(rgb >> 16U);
+        uniformColor.g = static_cast<std::uint8_t>(rgb >> 8U);
+        uniformColor.b = static_cast<std::uint8_t>(rgb);
+        uniformColor.a = 255;
+        return uniformColor;
+    }
+
+    // Writes a binary PLY file directly from the point clouds, skipping NaNs on the fly. The vertex count in the header
+    // has a fixed width, so point clouds from several cameras can be appended before the count is filled in. The SNR
+    // of each point is written as an extra property if requested.
+    class PLYWriter
+    {
+    public:
+        PLYWriter(const std::string &fileName, const bool withSNR)
+            : mFile(fileName, std::ios::binary)
+            , mWithSNR{ withSNR }
+            , mVertexSize{ 3 * sizeof(float) + 3 * sizeof(std::uint8_t) + (withSNR ? sizeof(float) : 0) }
+        {
+            if(!mFile)
+            {
+                throw std::runtime_error("Failed to open file: " + fileName);
+            }
+            mBuffer.reserve(bufferSize);
+            writeHeader();
+        }
+
+        void append(const TransformedPoints &transformedPoints, const bool useRGB, const size_t cameraIndex)
+        {
+            const auto &data = transformedPoints.data;
+            const auto &snrs = transformedPoints.snrs;
+            if(mWithSNR && snrs.size() != data.size())
+            {
+                throw std::invalid_argument("Missing SNR values for PLY file");
+            }
+            for(size_t j = 0; j < data.size(); j++)
+            {
+                const auto &p = data(j);
+                if(!std::isnan(p.point.x))
+                {
+                    const auto color = pointColor(p.color, useRGB, cameraIndex);
+                    const float snr = mWithSNR ? snrs[j].value : 0.F;
+                    appendVertex(p.point.x, p.point.y, p.point.z, color.r, color.g, color.b, snr);
+                }
+            }
+        }
+
+        void append(const pcl::PointCloud<pcl::PointXYZRGB> &pointCloud, const std::vector<float> &snrs)
+        {
+            if(mWithSNR && snrs.size() != pointCloud.points.size())
+            {
+                throw std::invalid_argument("Missing SNR values for PLY file");
+            }
+            for(size_t j = 0; j < pointCloud.points.size(); j++)
+            {
+                const auto &p = pointCloud.points[j];
+                if(!std::isnan(p.x))
+                {
+                    appendVertex(p.x, p.y, p.z, p.r, p.g, p.b, mWithSNR ? snrs[j] : 0.F);
+                }
+            }
+        }
+
+        void finish()
+        {
+            flushBuffer();
+            mFile.seekp(0);
+            writeHeader();
+            mFile.close();
+            if(!mFile)
+            {
+                throw std::runtime_error("Failed to write PLY file");
+            }
+        }
+
+        size_t numberOfPoints() const
+        {
+            return mNumberOfPoints;
+        }
+
+    private:
+        static constexpr size_t bufferSize = 1U << 22U;
+
+        void writeHeader()
+        {
+            mFile << "ply\n"
+                  << "format binary_little_endian 1.0\n"
+                  << "element vertex " << std::setw(20) << mNumberOfPoints << "\n"
+                  << "property float x\n"
+                  << "property float y\n"
+                  << "property float z\n"
+                  << "property uchar red\n"
+                  << "property uchar green\n"
+                  << "property uchar blue\n"
+                  << (mWithSNR ? "property float snr\n" : "") << "end_header\n";
+        }
+
+        void appendVertex(
+            const float x,
+            const float y,
+            const float z,
+            const std::uint8_t r,
+            const std::uint8_t g,
+            const std::uint8_t b,
+            const float snr)
+        {
+            if(mBuffer.size() + mVertexSize > bufferSize)
+            {
+                flushBuffer();
+            }
+            const std::array<float, 3> xyz{ { x, y, z } };
+            const std::array<std::uint8_t, 3> rgb{ { r, g, b } };
+            const auto *xyzBytes = reinterpret_cast<const char *>(xyz.data());
+            const auto *rgbBytes = reinterpret_cast<const char *>(rgb.data());
+            mBuffer.insert(mBuffer.end(), xyzBytes, xyzBytes + sizeof(xyz));
+            mBuffer.insert(mBuffer.end(), rgbBytes, rgbBytes + sizeof(rgb));
+            if(mWithSNR)
+            {
+                const auto *snrBytes = reinterpret_cast<const char *>(&snr);
+                mBuffer.insert(mBuffer.end(), snrBytes, snrBytes + sizeof(snr));
+            }
+            mNumberOfPoints++;
+        }
+
+        void flushBuffer()
+        {
+            mFile.write(mBuffer.data(), static_cast<std::streamsize>(mBuffer.size()));
+            mBuffer.clear();
+        }
+
+        std::ofstream mFile;
+        const bool mWithSNR;
+        const size_t mVertexSize;
+        std::vector<char> mBuffer;
+        size_t mNumberOfPoints = 0;
+    };
+
+    void copyValidPoints(
+        const Zivid::Array2D<Zivid::PointXYZColorRGBA> &data,
+        pcl::PointXYZRGB *destination,
+        const bool useRGB,
+        const size_t cameraIndex)
+    {
+        for(const auto &p : data)
+        {
+            if(!std::isnan(p.point.x))
+            {
+                const auto color = pointColor(p.color, useRGB, cameraIndex);
+                destination->x = p.point.x;
+                destination->y = p.point.y;
+                destination->z = p.point.z;
+                destination->r = color.r;
+                destination->g = color.g;
+                destination->b = color.b;
+                destination++;
+            }
+        }
+    }
+
+    pcl::PointCloud<pcl::PointXYZRGB> stitchInParallel(
+        const std::vector<TransformedPoints> &transformedPoints,
+        const bool useRGB)
+    {
+        // The valid points of each camera are written after the valid points of all previous cameras
+        std::vector<size_t> offsets(transformedPoints.size() + 1, 0);
+        for(size_t i = 0; i < transformedPoints.size(); i++)
+        {
+            offsets.at(i + 1) = offsets.at(i) + transformedPoints.at(i).numberOfValidPoints;
+        }
+
+        // Creating a PointCloud structure, unorganized skipping NaNs, allocated once for all cameras
+        pcl::PointCloud<pcl::PointXYZRGB> stitchedPointCloud;
+        stitchedPointCloud.points.resize(offsets.back());
+        stitchedPointCloud.width = offsets.back();
+        stitchedPointCloud.height = 1;
+        stitchedPointCloud.is_dense = true;
+
+        // Filling in the cloud data, with each camera writing to its own part of the point cloud in parallel
+        std::vector<std::future<void>> futureStitches;
+        for(size_t i = 0; i < transformedPoints.size(); i++)
+        {
+            futureStitches.emplace_back(std::async(
+                std::launch::async,
+                copyValidPoints,
+                std::cref(transformedPoints.at(i).data),
+                stitchedPointCloud.points.data() + offsets.at(i),
+                useRGB,
+                i));
+        }
+        for(auto &futureStitch : futureStitches)
+        {
+            futureStitch.get();
+        }
+        return stitchedPointCloud;
+    }
+
+    void mergeIntoVoxels(
+        VoxelHashMerger &merger,
+        const TransformedPoints &transformedPoints,
+        const bool useRGB,
+        const size_t cameraIndex)
+    {
+        const auto &data = transformedPoints.data;
+        const auto &snrs = transformedPoints.snrs;
+        for(size_t j = 0; j < data.size(); j++)
+        {
+            if(!std::isnan(data(j).point.x))
+            {
+                const float snr = snrs.empty() ? 0.F : snrs[j].value;
+                merger.add(
+                    data(j).point,
+                    pointColor(data(j).color, useRGB, cameraIndex),
+                    snr,
+                    static_cast<std::uint32_t>(cameraIndex));
+            }
+        }
+    }
+
+    // Hands the index of each camera over to the stitching thread in the order that the cameras finish
+    class CompletionQueue
+    {
+    public:
+        void push(const size_t cameraIndex)
+        {
+            {
+                const std::lock_guard<std::mutex> lock(mMutex);
+                mCameraIndices.push(cameraIndex);
+            }
+            mCondition.notify_one();
+        }
+
+        size_t pop()
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return !mCameraIndices.empty(); });
+            const auto cameraIndex = mCameraIndices.front();
+            mCameraIndices.pop();
+            return cameraIndex;
+        }
+
+    private:
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::queue<size_t> mCameraIndices;
+    };
+
+    TransformedPoints captureAndTransform(
+        Zivid::Camera &camera,
+        const Zivid::Matrix4x4 &transformationMatrix,
+        const bool copySNRs,
+        CompletionQueue &completedCameras,
+        const size_t cameraIndex)
+    {
+        try
+        {
+            const auto frame = assistedCapture(camera);
+            auto transformedPoints = transformAndCopy(frame, transformationMatrix, copySNRs);
+            completedCameras.push(cameraIndex);
+            return transformedPoints;
+        }
+        catch(...)
+        {
+            // The stitching thread is still notified, and gets the exception from the future
+            completedCameras.push(cameraIndex);
+            throw;
+        }
+    }
 } // namespace
 
 int main(int argc, char **argv)
@@ -118,13 +618,24 @@ int main(int argc, char **argv)
         std::string stitchedPointCloudFileName;
         auto useRGB = true;
         auto saveStitched = false;
+        auto saveSNR = false;
+        auto voxelSize = 0.F;
+        auto mergePolicy = MergePolicy::first;
         auto cli =
             (clipp::values("File Names", transformationMatricesfileList)
                  % "List of YAML files containing the transformation matrix.",
              clipp::option("-m", "--mono-chrome").set(useRGB, false) % "Color each point cloud with unique color.",
+             clipp::option("-v", "--voxel-size") & clipp::value("Voxel size in mm", voxelSize)
+                 % "Merge points from overlapping cameras that fall into the same voxel of this size.",
+             clipp::option("--merge-policy")
+                 & (clipp::command("first").set(mergePolicy, MergePolicy::first)
+                    | clipp::command("average").set(mergePolicy, MergePolicy::average)
+                    | clipp::command("snr").set(mergePolicy, MergePolicy::highestSNR))
+                       % "Keep the first point, the average, or the point with highest SNR in each voxel.",
              clipp::required("-o", "--output-file").set(saveStitched)
                  & clipp::value("Output point cloud (PLY) file name", stitchedPointCloudFileName)
-                       % "Save the stitched point cloud to a file with this name. (.ply)");
+                       % "Save the stitched point cloud to a file with this name. (.ply)",
+             clipp::option("--save-snr").set(saveSNR) % "Save the SNR of each point in the PLY file.");
 
         if(!parse(argc, argv, cli))
         {
@@ -142,67 +653,52 @@ int main(int argc, char **argv)
         const auto transformsMappedToCameras =
             getTransformationMatricesFromYAML(transformationMatricesfileList, connectedCameras);
 
-        // Capture from all cameras
-        auto frames = std::vector<Zivid::Frame>();
-        auto maxNumberOfPoints = 0;
-        for(const auto &transformAndCamera : transformsMappedToCameras)
+        // Capture from all cameras in parallel. Each point cloud is transformed and copied in the same thread as
+        // soon as its capture is done, while the other cameras are still capturing.
+        const bool copySNRs = saveSNR || (voxelSize > 0.F && mergePolicy == MergePolicy::highestSNR);
+        CompletionQueue completedCameras;
+        std::vector<std::future<TransformedPoints>> futureTransformedPoints;
+        std::vector<std::string> serialNumbers;
+        for(size_t i = 0; i < transformsMappedToCameras.size(); i++)
         {
-            std::cout << "Imaging from camera: " << transformAndCamera.mCamera.info().serialNumber() << std::endl;
-            const auto frame = assistedCapture(transformAndCamera.mCamera);
-            const auto resolution =
-                Zivid::Experimental::SettingsInfo::resolution(transformAndCamera.mCamera.info(), frame.settings());
-            maxNumberOfPoints += resolution.size();
-            frames.push_back(frame);
+            serialNumbers.push_back(transformsMappedToCameras.at(i).mCamera.info().serialNumber().toString());
+            std::cout << "Imaging from camera: " << serialNumbers.back() << std::endl;
+            futureTransformedPoints.emplace_back(std::async(
+                std::launch::async,
+                captureAndTransform,
+                std::ref(transformsMappedToCameras.at(i).mCamera),
+                std::cref(transformsMappedToCameras.at(i).mTransformationMatrix),
+                copySNRs,
+                std::ref(completedCameras),
+                i));
         }
 
-        // Stitch frames
-        // Creating a PointCloud structure
-        pcl::PointCloud<pcl::PointXYZRGB> stitchedPointCloud;
-
-        // Filling in the cloud data, unorganized skipping NaNs
-        stitchedPointCloud.points.resize(maxNumberOfPoints);
-
-        size_t validPoints = 0;
-        for(size_t i = 0; i < transformsMappedToCameras.size(); i++)
+        // Stitch frames. The transform, copy and valid point count of each camera run in its capture thread, and
+        // voxel merging runs as soon as a point cloud is ready. Without merging, the valid point counts give each
+        // camera its own part of a single stitched point cloud, which all cameras fill in parallel. Only this thread
+        // prints, so the messages do not interleave.
+        VoxelHashMerger merger(voxelSize, mergePolicy);
+        std::vector<TransformedPoints> transformedPoints(futureTransformedPoints.size());
+        size_t maxNumberOfPoints = 0;
+        for(size_t i = 0; i < futureTransformedPoints.size(); i++)
         {
-            auto pointCloud = frames.at(i).pointCloud();
-
-            // Transform point cloud
-            pointCloud.transform(transformsMappedToCameras.at(i).mTransformationMatrix);
-
-            // Stitch, and add color
-            const auto rgba = pointCloud.copyColorsRGBA();
-            const auto xyz = pointCloud.copyPointsXYZ();
-            for(size_t j = 0; j < pointCloud.size(); j++)
+            const auto cameraIndex = completedCameras.pop();
+            auto cameraPoints = futureTransformedPoints.at(cameraIndex).get();
+            std::cout << "Got point cloud from camera: " << serialNumbers.at(cameraIndex) << std::endl;
+            maxNumberOfPoints += cameraPoints.data.size();
+            if(voxelSize > 0.F)
             {
-                if(!isnan(xyz(j).x))
-                {
-                    stitchedPointCloud.points[validPoints].x =
-                        xyz(j).x; // NOLINT(cppcoreguidelines-pro-type-union-access)
-                    stitchedPointCloud.points[validPoints].y =
-                        xyz(j).y; // NOLINT(cppcoreguidelines-pro-type-union-access)
-                    stitchedPointCloud.points[validPoints].z =
-                        xyz(j).z; // NOLINT(cppcoreguidelines-pro-type-union-access)
-                    if(useRGB)
-                    {
-                        stitchedPointCloud.points[validPoints].r =
-                            rgba(j).r; // NOLINT(cppcoreguidelines-pro-type-union-access)
-                        stitchedPointCloud.points[validPoints].g =
-                            rgba(j).g; // NOLINT(cppcoreguidelines-pro-type-union-access)
-                        stitchedPointCloud.points[validPoints].b =
-                            rgba(j).b; // NOLINT(cppcoreguidelines-pro-type-union-access)
-                    }
-                    else
-                    {
-                        stitchedPointCloud.points[validPoints].rgb = rgbList.at(i);
-                    }
-                    validPoints++;
-                }
+                mergeIntoVoxels(merger, cameraPoints, useRGB, cameraIndex);
+            }
+            else
+            {
+                transformedPoints.at(cameraIndex) = std::move(cameraPoints);
             }
         }
-        // Remove unused memory (would have been occupied by NaNs)
-        stitchedPointCloud.points.resize(validPoints);
-        std::cout << "Got " << validPoints << " out of " << maxNumberOfPoints << " points" << std::endl;
+        const auto stitchedPointCloud =
+            voxelSize > 0.F ? merger.pointCloud() : stitchInParallel(transformedPoints, useRGB);
+        std::cout << "Got " << stitchedPointCloud.points.size() << " out of " << maxNumberOfPoints << " points"
+                  << std::endl;
 
         // Simple Cloud Visualization
         pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloudPTR(new pcl::PointCloud<pcl::PointXYZRGB>);
@@ -218,9 +714,22 @@ int main(int argc, char **argv)
         }
         if(saveStitched)
         {
-            std::cerr << "Saving " << stitchedPointCloud.points.size()
-                      << " data points to " + stitchedPointCloudFileName << std::endl;
-            pcl::io::savePLYFileBinary(stitchedPointCloudFileName, stitchedPointCloud);
+            std::cout << "Saving stitched point cloud to " << stitchedPointCloudFileName << std::endl;
+            PLYWriter writer(stitchedPointCloudFileName, saveSNR);
+            if(voxelSize > 0.F)
+            {
+                writer.append(stitchedPointCloud, saveSNR ? merger.snrs() : std::vector<float>{});
+            }
+            else
+            {
+                // Each camera is streamed from its Zivid data into the same file
+                for(size_t i = 0; i < transformedPoints.size(); i++)
+                {
+                    writer.append(transformedPoints.at(i), useRGB, i);
+                }
+            }
+            writer.finish();
+            std::cerr << "Saved " << writer.numberOfPoints() << " data points" << std::endl;
         }
     }
     catch(const std::exception &e)
@@ -10,65 +10,168 @@ Use transformation matrices from Multi-Camera calibration to transform point clo
 
 #include <Zivid/Zivid.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
 #include <vector>
 
 namespace
 {
-    class TransformationMatrixAndFrameMap
+    std::string fileExtension(const std::string &fileName)
     {
-    public:
-        TransformationMatrixAndFrameMap(Zivid::Matrix4x4 transformationMatrix, Zivid::Frame frame)
-            : mTransformationMatrix(transformationMatrix)
-            , mFrame(std::move(frame))
-        {}
+        return fileName.substr(fileName.find_last_of('.') + 1);
+    }
+
+    // Maps the serial number in the name of each YAML file to the file, so that each ZDF is matched by a single lookup
+    std::map<std::string, std::string> indexYAMLFilesBySerialNumber(const std::vector<std::string> &fileList)
+    {
+        std::map<std::string, std::string> yamlFiles;
+        for(const auto &fileName : fileList)
+        {
+            const auto extension = fileExtension(fileName);
+            if(extension == "yaml" || extension == "yml")
+            {
+                const auto begin = fileName.find_last_of("\\/") + 1;
+                yamlFiles[fileName.substr(begin, fileName.find_last_of('.') - begin)] = fileName;
+            }
+        }
+        return yamlFiles;
+    }
 
-        const Zivid::Matrix4x4 mTransformationMatrix;
-        const Zivid::Frame mFrame;
+    struct LoadedPointCloud
+    {
+        size_t fileIndex;
+        size_t numberOfPoints;
+        std::vector<Zivid::PointXYZColorRGBA> validPoints;
+        std::exception_ptr error;
     };
 
-    std::vector<TransformationMatrixAndFrameMap> getTransformationMatricesAndFramesFromZDF(
-        const std::vector<std::string> &transformationMatricesfileList)
+    // Transforms the valid points while compacting them to the front of the buffer, so that the transform costs no
+    // extra traversal of the point cloud. NaN points are skipped. With double as AccumulateType, the products are
+    // summed in double precision, which avoids loss of precision for transforms with large translations.
+    template<typename AccumulateType>
+    void transformAndCompact(
+        std::vector<Zivid::PointXYZColorRGBA> &points,
+        const Zivid::Matrix4x4 &transformationMatrix)
+    {
+        std::array<AccumulateType, 12> m{};
+        for(size_t row = 0; row < 3; row++)
+        {
+            for(size_t column = 0; column < 4; column++)
+            {
+                m[row * 4 + column] = transformationMatrix(row, column);
+            }
+        }
+
+        size_t numberOfValidPoints = 0;
+        for(size_t i = 0; i < points.size(); i++)
+        {
+            const auto p = points[i];
+            if(!std::isnan(p.point.x))
+            {
+                const AccumulateType x = p.point.x;
+                const AccumulateType y = p.point.y;
+                const AccumulateType z = p.point.z;
+                auto &transformed = points[numberOfValidPoints++];
+                transformed.point.x = static_cast<float>(m[0] * x + m[1] * y + m[2] * z + m[3]);
+                transformed.point.y = static_cast<float>(m[4] * x + m[5] * y + m[6] * z + m[7]);
+                transformed.point.z = static_cast<float>(m[8] * x + m[9] * y + m[10] * z + m[11]);
+                transformed.color = p.color;
+            }
+        }
+        points.resize(numberOfValidPoints);
+    }
+
+    LoadedPointCloud loadAndTransform(
+        const size_t fileIndex,
+        const std::string &zdfFileName,
+        const std::map<std::string, std::string> &yamlFiles,
+        const bool doublePrecision)
     {
-        std::string fileExtension;
-        std::string serialNumber;
+        const auto frame = Zivid::Frame(zdfFileName);
+        const auto serialNumber = frame.cameraInfo().serialNumber().toString();
+        const auto yamlFile = yamlFiles.find(serialNumber);
+        if(yamlFile == yamlFiles.end())
+        {
+            throw std::runtime_error("You are missing a YAML file named " + serialNumber + ".yaml!");
+        }
+        const auto transformationMatrix = Zivid::Matrix4x4(yamlFile->second);
+
+        // Copying points and colors in a single copy, then transforming and compacting the valid points in place
+        const auto pointCloud = frame.pointCloud();
+        std::vector<Zivid::PointXYZColorRGBA> points(pointCloud.size());
+        pointCloud.copyData(points.data());
+        if(doublePrecision)
+        {
+            transformAndCompact<double>(points, transformationMatrix);
+        }
+        else
+        {
+            transformAndCompact<float>(points, transformationMatrix);
+        }
+
+        return LoadedPointCloud{ fileIndex, pointCloud.size(), std::move(points), nullptr };
+    }
 
-        auto transformsMappedToFrames = std::vector<TransformationMatrixAndFrameMap>{};
-        for(const auto &zdfFileName : transformationMatricesfileList)
+    // Hands each loaded point cloud over to the stitching thread as soon as it is ready
+    class LoadedPointCloudQueue
+    {
+    public:
+        void push(LoadedPointCloud loadedPointCloud)
         {
-            fileExtension = zdfFileName.substr(zdfFileName.find_last_of('.') + 1);
-            if(fileExtension == "zdf")
             {
-                const auto frame = Zivid::Frame(zdfFileName);
-                serialNumber = frame.cameraInfo().serialNumber().toString();
-                for(const auto &yamlFileName : transformationMatricesfileList)
-                {
-                    std::cout << "Searching in " << yamlFileName << std::endl;
-                    if(serialNumber
-                       == yamlFileName.substr(
-                           yamlFileName.find_last_of("\\/") + 1,
-                           (yamlFileName.find_last_of('.')) - (yamlFileName.find_last_of("\\/") + 1)))
-                    {
-                        Zivid::Matrix4x4 transformationMatrixZivid(yamlFileName);
-                        transformsMappedToFrames.emplace_back(transformationMatrixZivid, frame);
-                        break;
-                    }
-                    if(transformationMatricesfileList.back() == yamlFileName)
-                    {
-                        throw std::runtime_error("You are missing a YAML file named " + serialNumber + ".yaml!");
-                    }
-                }
+                const std::lock_guard<std::mutex> lock(mMutex);
+                mLoadedPointClouds.push(std::move(loadedPointCloud));
             }
+            mCondition.notify_one();
         }
-        if(transformsMappedToFrames.size() < 2)
+
+        LoadedPointCloud pop()
         {
-            throw std::runtime_error(
-                "Require minimum two matching transformation and frames, got "
-                + std::to_string(transformsMappedToFrames.size()));
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return !mLoadedPointClouds.empty(); });
+            auto loadedPointCloud = std::move(mLoadedPointClouds.front());
+            mLoadedPointClouds.pop();
+            return loadedPointCloud;
         }
 
-        return transformsMappedToFrames;
+    private:
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::queue<LoadedPointCloud> mLoadedPointClouds;
+    };
+
+    // Each worker takes the next ZDF file that no other worker has started on, until all files are loaded or loading
+    // is cancelled
+    void loadWorker(
+        const std::vector<std::string> &zdfFileNames,
+        const std::map<std::string, std::string> &yamlFiles,
+        const bool doublePrecision,
+        std::atomic<size_t> &nextFileIndex,
+        const std::atomic<bool> &cancelled,
+        LoadedPointCloudQueue &loadedPointClouds)
+    {
+        for(size_t i = nextFileIndex++; i < zdfFileNames.size() && !cancelled; i = nextFileIndex++)
+        {
+            try
+            {
+                loadedPointClouds.push(loadAndTransform(i, zdfFileNames.at(i), yamlFiles, doublePrecision));
+            }
+            catch(...)
+            {
+                loadedPointClouds.push(LoadedPointCloud{ i, 0, {}, std::current_exception() });
+            }
+        }
     }
 
     const auto rgbList = std::array<std::uint32_t, 16>{
@@ -89,6 +192,29 @@ namespace
         0xF13A13, // Vivid Reddish Orange
         0x7F180D, // Strong Reddish Brown
     };
+
+    void appendValidPoints(
+        pcl::PointCloud<pcl::PointXYZRGB> &stitchedPointCloud,
+        const std::vector<Zivid::PointXYZColorRGBA> &validPoints,
+        const bool useRGB,
+        const size_t fileIndex)
+    {
+        const auto uniformColor = rgbList.at(fileIndex % rgbList.size());
+        auto &points = stitchedPointCloud.points;
+        const auto offset = points.size();
+        points.resize(offset + validPoints.size());
+        for(size_t i = 0; i < validPoints.size(); i++)
+        {
+            const auto &p = validPoints[i];
+            auto &point = points[offset + i];
+            point.x = p.point.x;
+            point.y = p.point.y;
+            point.z = p.point.z;
+            point.r = useRGB ? p.color.r : static_cast<std::uint8_t>(uniformColor >> 16U);
+            point.g = useRGB ? p.color.g : static_cast<std::uint8_t>(uniformColor >> 8U);
+            point.b = useRGB ? p.color.b : static_cast<std::uint8_t>(uniformColor);
+        }
+    }
 } // namespace
 
 int main(int argc, char **argv)
@@ -100,11 +226,14 @@ int main(int argc, char **argv)
         std::string stitchedPointCloudFileName;
         auto transformationMatricesAndZdfFileList = std::vector<std::string>{};
         auto useRGB = true;
+        auto doublePrecision = false;
         auto saveStitched = false;
         auto cli =
             (clipp::values("File Names", transformationMatricesAndZdfFileList)
                  % "List of ZDF files to stitch and list of YAML files containing the transformation matrix.",
              clipp::option("-m", "--mono-chrome").set(useRGB, false) % "Color each point cloud with unique color.",
+             clipp::option("-d", "--double-precision").set(doublePrecision, true)
+                 % "Accumulate the transformation of each point in double precision.",
              clipp::required("-o", "--output-file").set(saveStitched)
                  & clipp::value("Output point cloud (PLY) file name", stitchedPointCloudFileName)
                        % "Save the stitched point cloud to a file with this name. (.ply)");
@@ -119,63 +248,61 @@ int main(int argc, char **argv)
             throw std::runtime_error("No file provided.");
         }
 
-        const auto transformsMappedToFrames =
-            getTransformationMatricesAndFramesFromZDF(transformationMatricesAndZdfFileList);
+        const auto yamlFiles = indexYAMLFilesBySerialNumber(transformationMatricesAndZdfFileList);
+        auto zdfFileNames = std::vector<std::string>{};
+        std::copy_if(
+            transformationMatricesAndZdfFileList.begin(),
+            transformationMatricesAndZdfFileList.end(),
+            std::back_inserter(zdfFileNames),
+            [](const std::string &fileName) { return fileExtension(fileName) == "zdf"; });
+        if(zdfFileNames.size() < 2)
+        {
+            throw std::runtime_error("Require minimum two ZDF files, got " + std::to_string(zdfFileNames.size()));
+        }
 
-        // Loop through frames to find final size
-        auto maxNumberOfPoints = 0;
-        for(const auto &frameMap : transformsMappedToFrames)
+        // Load and transform the ZDF files on a bounded number of worker threads
+        const size_t numberOfWorkers =
+            std::min<size_t>(zdfFileNames.size(), std::max(1U, std::thread::hardware_concurrency()));
+        std::atomic<size_t> nextFileIndex{ 0 };
+        std::atomic<bool> cancelled{ false };
+        LoadedPointCloudQueue loadedPointClouds;
+        std::vector<std::future<void>> workers;
+        for(size_t i = 0; i < numberOfWorkers; i++)
         {
-            maxNumberOfPoints += frameMap.mFrame.pointCloud().width() * frameMap.mFrame.pointCloud().height();
+            workers.emplace_back(std::async(
+                std::launch::async,
+                loadWorker,
+                std::cref(zdfFileNames),
+                std::cref(yamlFiles),
+                doublePrecision,
+                std::ref(nextFileIndex),
+                std::cref(cancelled),
+                std::ref(loadedPointClouds)));
         }
 
-        // Stitch frames
-        // Creating a PointCloud structure
+        // Stitch frames, unorganized skipping NaNs, in the order they finish loading. The stitched point cloud is
+        // reserved once for the resolution of the first loaded file times the number of files, which holds all valid
+        // points unless the files come from cameras with different resolutions. On the first error the workers are
+        // cancelled, so that they do not load the remaining files before the error is reported.
         pcl::PointCloud<pcl::PointXYZRGB> stitchedPointCloud;
-
-        // Filling in the cloud data, unorganized skipping NaNs
-        stitchedPointCloud.points.resize(maxNumberOfPoints);
-
-        size_t validPoints = 0;
-        for(size_t i = 0; i < transformsMappedToFrames.size(); i++)
+        size_t maxNumberOfPoints = 0;
+        for(size_t i = 0; i < zdfFileNames.size(); i++)
         {
-            auto pointCloud = transformsMappedToFrames.at(i).mFrame.pointCloud();
-
-            // Transform point cloud
-            pointCloud.transform(transformsMappedToFrames.at(i).mTransformationMatrix);
-
-            // Stitch, and add color
-            const auto rgba = pointCloud.copyColorsRGBA();
-            const auto xyz = pointCloud.copyPointsXYZ();
-            for(size_t j = 0; j < pointCloud.size(); j++)
+            auto loadedPointCloud = loadedPointClouds.pop();
+            if(loadedPointCloud.error)
+            {
+                cancelled = true;
+                std::rethrow_exception(loadedPointCloud.error);
+            }
+            if(i == 0)
             {
-                if(!isnan(xyz(j).x))
-                {
-                    stitchedPointCloud.points[validPoints].x =
-                        xyz(j).x; // NOLINT(cppcoreguidelines-pro-type-union-access)
-                    stitchedPointCloud.points[validPoints].y =
-                        xyz(j).y; // NOLINT(cppcoreguidelines-pro-type-union-access)
-                    stitchedPointCloud.points[validPoints].z =
-                        xyz(j).z; // NOLINT(cppcoreguidelines-pro-type-union-access)
-                    if(useRGB)
-                    {
-                        stitchedPointCloud.points[validPoints].r =
-                            rgba(j).r; // NOLINT(cppcoreguidelines-pro-type-union-access)
-                        stitchedPointCloud.points[validPoints].g =
-                            rgba(j).g; // NOLINT(cppcoreguidelines-pro-type-union-access)
-                        stitchedPointCloud.points[validPoints].b =
-                            rgba(j).b; // NOLINT(cppcoreguidelines-pro-type-union-access)
-                    }
-                    else
-                    {
-                        stitchedPointCloud.points[validPoints].rgb = rgbList.at(i);
-                    }
-                    validPoints++;
-                }
+                stitchedPointCloud.points.reserve(loadedPointCloud.numberOfPoints * zdfFileNames.size());
             }
+            std::cout << "Stitching " << zdfFileNames.at(loadedPointCloud.fileIndex) << std::endl;
+            appendValidPoints(stitchedPointCloud, loadedPointCloud.validPoints, useRGB, loadedPointCloud.fileIndex);
+            maxNumberOfPoints += loadedPointCloud.numberOfPoints;
         }
-        // Remove unused memory (would have been occupied by NaNs)
-        stitchedPointCloud.points.resize(validPoints);
+        const size_t validPoints = stitchedPointCloud.points.size();
         std::cout << "Got " << validPoints << " out of " << maxNumberOfPoints << " points" << std::endl;
 
         // Simple Cloud Visualization
@@ -12,8 +12,12 @@ allowing us to find the 3D coordinates relative to the camera.
 
 #include <opencv2/opencv.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iostream>
+#include <stdexcept>
+#include <vector>
 
 namespace
 {
@@ -71,32 +75,49 @@ namespace
         return bgr;
     }
 
-    cv::Mat croppedGrayFloatImage(const cv::Mat &bgr, int cropRows)
+    float grayValue(const Zivid::ColorRGBA &color)
     {
-        const auto cropped = bgr(cv::Range{ cropRows, bgr.rows - cropRows }, cv::Range{ 0, bgr.cols });
-
-        cv::Mat grayImage;
-        cv::cvtColor(cropped, grayImage, cv::COLOR_BGR2GRAY);
-
-        cv::Mat outputImage;
-        grayImage.convertTo(outputImage, CV_32F);
-        return outputImage;
+        // Same weights as cv::COLOR_RGBA2GRAY
+        return 0.299F * static_cast<float>(color.r) + 0.587F * static_cast<float>(color.g)
+               + 0.114F * static_cast<float>(color.b);
     }
 
-    cv::Mat
-    normalize(const cv::Mat &markerImage, const cv::Mat &illuminatedSceneImage, const cv::Mat &nonIlluminatedSceneImage)
+    // Converts the three images to gray and normalizes the marker image in a single pass, without intermediate images.
+    // The difference between the illuminated and non-illuminated scene is used to normalize the marker image.
+    void normalizedGrayImage(
+        const Zivid::Image<Zivid::ColorRGBA> &markerImage,
+        const Zivid::Image<Zivid::ColorRGBA> &illuminatedSceneImage,
+        const Zivid::Image<Zivid::ColorRGBA> &nonIlluminatedSceneImage,
+        const int cropRows,
+        cv::Mat &normalizedImage)
     {
-        // We use the difference between the light and dark background images to normalize the marker image
-        cv::Mat difference = illuminatedSceneImage - nonIlluminatedSceneImage;
+        const auto width = markerImage.width();
+        const auto height = markerImage.height();
+        if(illuminatedSceneImage.width() != width || illuminatedSceneImage.height() != height
+           || nonIlluminatedSceneImage.width() != width || nonIlluminatedSceneImage.height() != height)
+        {
+            throw std::invalid_argument("The marker and scene images must have the same resolution");
+        }
 
         // Avoid divide-by-zero by ignoring pixels with little value difference
-        const auto differenceLimit = 100.0;
-        const auto invalidDifference = difference < differenceLimit;
-        difference.setTo(1, invalidDifference);
+        const auto differenceLimit = 100.F;
 
-        cv::Mat normalizedImage = (markerImage - nonIlluminatedSceneImage) / difference;
-        normalizedImage.setTo(0, invalidDifference);
-        return normalizedImage;
+        normalizedImage.create(static_cast<int>(height) - 2 * cropRows, static_cast<int>(width), CV_32F);
+        for(int row = 0; row < normalizedImage.rows; row++)
+        {
+            const auto offset = static_cast<size_t>(row + cropRows) * width;
+            const auto *marker = markerImage.data() + offset;
+            const auto *illuminated = illuminatedSceneImage.data() + offset;
+            const auto *nonIlluminated = nonIlluminatedSceneImage.data() + offset;
+            auto *normalized = normalizedImage.ptr<float>(row);
+            for(size_t column = 0; column < width; column++)
+            {
+                const auto dark = grayValue(nonIlluminated[column]);
+                const auto difference = grayValue(illuminated[column]) - dark;
+                normalized[column] =
+                    difference < differenceLimit ? 0.F : (grayValue(marker[column]) - dark) / difference;
+            }
+        }
     }
 
     double projectorToCameraScaleFactor(const Zivid::CameraInfo &cameraInfo)
@@ -118,35 +139,110 @@ namespace
         throw std::invalid_argument("Invalid camera model");
     }
 
-    cv::Point findMarker(
-        const Zivid::Frame2D &projectedMarkerFrame2D,
-        const Zivid::Frame2D &illuminatedSceneFrame2D,
-        const Zivid::Frame2D &nonIlluminatedSceneFrame2D,
-        const Zivid::Resolution &markerResolution,
-        const Zivid::CameraInfo &cameraInfo)
+    // Finds the projected marker coarse-to-fine: the whole image is searched on the coarsest pyramid level, and the
+    // location is then refined in a window on each finer level. The marker kernels are built once, and the image
+    // buffers are reused between calls.
+    class MarkerLocator
     {
-        constexpr int croppedRows = 400;
+    public:
+        MarkerLocator(const Zivid::Resolution &markerResolution, const Zivid::CameraInfo &cameraInfo)
+        {
+            const double blurSigma = 1.0;
+            cv::Mat blurredMarker;
+            cv::GaussianBlur(
+                createMarker(markerResolution, CV_32F, 1, 0), blurredMarker, cv::Size{ 5, 5 }, blurSigma, blurSigma);
+
+            const auto scaleFactor = projectorToCameraScaleFactor(cameraInfo);
+            mKernels.emplace_back();
+            cv::resize(blurredMarker, mKernels.front(), {}, scaleFactor, scaleFactor);
+
+            // The marker lines are one projector pixel wide, and the blur widens them to a full width at half maximum
+            // of about sqrt(1 + (2.355 * sigma)^2) projector pixels. A coarser level is only used while the lines stay
+            // at least two pixels wide on it, so that they are still sampled, and while the kernel keeps the marker
+            // shape.
+            const double minLineWidth = 2.0;
+            const int minKernelSize = 9;
+            const size_t maxNumberOfLevels = 4;
+            auto lineWidth = std::sqrt(1.0 + std::pow(2.355 * blurSigma, 2)) * scaleFactor;
+            while(mKernels.size() < maxNumberOfLevels && lineWidth / 2 >= minLineWidth
+                  && std::min(mKernels.back().rows, mKernels.back().cols) / 2 >= minKernelSize)
+            {
+                cv::Mat kernel;
+                cv::pyrDown(mKernels.back(), kernel);
+                mKernels.push_back(kernel);
+                lineWidth /= 2;
+            }
+            mImages.resize(mKernels.size());
+        }
 
-        const auto normalizedImage = normalize(
-            croppedGrayFloatImage(cvMatFromFrame2D(projectedMarkerFrame2D), croppedRows),
-            croppedGrayFloatImage(cvMatFromFrame2D(illuminatedSceneFrame2D), croppedRows),
-            croppedGrayFloatImage(cvMatFromFrame2D(nonIlluminatedSceneFrame2D), croppedRows));
+        size_t numberOfLevels() const
+        {
+            return mKernels.size();
+        }
 
-        cv::Mat blurredMarker;
-        cv::GaussianBlur(createMarker(markerResolution, CV_32F, 1, 0), blurredMarker, cv::Size{ 5, 5 }, 1.0, 1.0);
+        cv::Point find(
+            const Zivid::Frame2D &projectedMarkerFrame2D,
+            const Zivid::Frame2D &illuminatedSceneFrame2D,
+            const Zivid::Frame2D &nonIlluminatedSceneFrame2D)
+        {
+            normalizedGrayImage(
+                projectedMarkerFrame2D.imageRGBA(),
+                illuminatedSceneFrame2D.imageRGBA(),
+                nonIlluminatedSceneFrame2D.imageRGBA(),
+                croppedRows,
+                mImages.front());
+            for(size_t level = 1; level < mImages.size(); level++)
+            {
+                cv::pyrDown(mImages[level - 1], mImages[level]);
+            }
+
+            const auto coarsestLevel = mImages.size() - 1;
+            cv::filter2D(mImages[coarsestLevel], mCorrelation, -1, mKernels[coarsestLevel]);
+            cv::Point location;
+            cv::minMaxLoc(mCorrelation, nullptr, nullptr, nullptr, &location);
+
+            for(size_t level = coarsestLevel; level-- > 0;)
+            {
+                location = refine(mImages[level], mKernels[level], location * 2);
+            }
+
+            return location + cv::Point{ 0, croppedRows };
+        }
 
-        cv::Mat kernel;
-        const auto scaleFactor = projectorToCameraScaleFactor(cameraInfo);
-        cv::resize(blurredMarker, kernel, {}, scaleFactor, scaleFactor);
+        // Searches the whole full-resolution image from the last call to find(), without the pyramid. This is the
+        // reference that the coarse-to-fine result is checked against.
+        cv::Point findAtFullResolution()
+        {
+            cv::filter2D(mImages.front(), mCorrelation, -1, mKernels.front());
+            cv::Point location;
+            cv::minMaxLoc(mCorrelation, nullptr, nullptr, nullptr, &location);
+            return location + cv::Point{ 0, croppedRows };
+        }
 
-        cv::Mat convolvedImage;
-        cv::filter2D(normalizedImage, convolvedImage, -1, kernel);
+    private:
+        cv::Point refine(const cv::Mat &image, const cv::Mat &kernel, const cv::Point &guess)
+        {
+            // Covers the rounding error from the coarser level, and the shift of the correlation peak that the
+            // smoothing of the coarser levels can cause
+            const int searchRadius = 8;
+            const auto imageArea = cv::Rect(0, 0, image.cols, image.rows);
+            const auto searchArea =
+                cv::Rect(guess.x - searchRadius, guess.y - searchRadius, 2 * searchRadius + 1, 2 * searchRadius + 1)
+                & imageArea;
+
+            // filter2D on a sub-image reads the pixels around it, so the result equals that of the full image
+            cv::filter2D(image(searchArea), mCorrelation, -1, kernel);
+            cv::Point location;
+            cv::minMaxLoc(mCorrelation, nullptr, nullptr, nullptr, &location);
+            return location + searchArea.tl();
+        }
 
-        cv::Point brightestLocation;
-        cv::minMaxLoc(convolvedImage, nullptr, nullptr, nullptr, &brightestLocation);
+        static constexpr int croppedRows = 400;
 
-        return brightestLocation + cv::Point{ 0, croppedRows };
-    }
+        std::vector<cv::Mat> mKernels;
+        std::vector<cv::Mat> mImages;
+        cv::Mat mCorrelation;
+    };
 
     cv::Mat annotate(const Zivid::Frame2D &frame2D, const cv::Point &location)
     {
@@ -214,6 +310,7 @@ int main()
         const cv::Scalar markerColor{ 0, 255, 0, 255 };
         auto marker = createMarker(markerResolution, cvMatArrayType, markerColor, backgroundColor);
 
+        // The projector image is static, so the marker is drawn straight into the single projector image buffer
         std::cout << "Copying the marker image to the projector image" << std::endl;
         copyToCenter(marker, projectorImageOpenCV);
 
@@ -254,14 +351,24 @@ int main()
         const auto nonIlluminatedSceneFrame2D = camera.capture(settings2DZeroBrightness);
 
         std::cout << "Locating marker in the 2D image:" << std::endl;
-        const auto markerLocation = findMarker(
-            projectedMarkerFrame2D,
-            illuminatedSceneFrame2D,
-            nonIlluminatedSceneFrame2D,
-            markerResolution,
-            camera.info());
+        MarkerLocator markerLocator(markerResolution, camera.info());
+        const auto markerLocation =
+            markerLocator.find(projectedMarkerFrame2D, illuminatedSceneFrame2D, nonIlluminatedSceneFrame2D);
         std::cout << markerLocation << std::endl;
 
+        std::cout << "Checking the " << markerLocator.numberOfLevels()
+                  << "-level pyramid search against a search of the full-resolution image" << std::endl;
+        const auto fullResolutionMarkerLocation = markerLocator.findAtFullResolution();
+        if(fullResolutionMarkerLocation == markerLocation)
+        {
+            std::cout << "Both searches found the marker at " << markerLocation << std::endl;
+        }
+        else
+        {
+            std::cout << "Warning: The full-resolution search found the marker at " << fullResolutionMarkerLocation
+                      << std::endl;
+        }
+
         std::cout << "Capturing a point-cloud using Capture Assistant" << std::endl;
         const auto frame = captureWithCaptureAssistant(camera);
 
@@ -2,267 +2,283 @@
 Filter the point cloud based on a ROI box given relative to the ArUco marker on a Zivid Calibration Board.
 The ZFC file for this sample can be downloaded from https://support.zivid.com/en/latest/api-reference/samples/sample-data.html.
 
-This sample depends on ArUco libraries in OpenCV with extra modules (https://github.com/opencv/opencv_contrib).
+This sample depends on ArUco libraries in OpenCV with extra modules (https://github.com/opencv/opencv_contrib), and on
+the PoseEstimation library in source/Utilities.
 */
 
+#include <Zivid/Experimental/Calibration.h>
 #include <Zivid/Visualization/Visualizer.h>
 #include <Zivid/Zivid.h>
 
+#include <PoseEstimation/PoseEstimation.h>
+
 #include <algorithm>
+#include <opencv2/calib3d/calib3d.hpp>
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include <opencv2/aruco.hpp>
 
-#include <Eigen/Core>
-#include <Eigen/Dense>
-#include <Eigen/Geometry>
-
 #include <cmath>
 #include <iostream>
-#include <thread>
+#include <limits>
+#include <vector>
 
 namespace
 {
-    struct Line2d
-    {
-        float slope;
-        float intercept;
-    };
-
-    float clamp(const float n, const float lower, const float upper)
+    cv::Mat pointCloudToGray(const Zivid::PointCloud &pointCloud)
     {
-        return std::max(lower, std::min(n, upper));
+        const auto image = pointCloud.copyImageRGBA();
+        const auto rgba = cv::Mat(
+            pointCloud.height(),
+            pointCloud.width(),
+            CV_8UC4,
+            const_cast<void *>(static_cast<const void *>(image.data())));
+        cv::Mat gray;
+        cv::cvtColor(rgba, gray, cv::COLOR_RGBA2GRAY);
+        return gray;
     }
 
-    Line2d fitLine(const cv::Point2f &point1, const cv::Point2f &point2)
+    // Caches the pose of a static board with ArUco markers. For each new frame, the mean intensity and the mean depth
+    // in a small window around each cached marker corner are compared with the values from the last detection, and the
+    // markers are only detected again if they have changed.
+    class MarkerPoseTracker
     {
-        // Fitting a line y=a*x + b to 2 points
-        const auto slope{ (point2.y - point1.y) / (point2.x - point1.x) };
-        const auto intercept{ point1.y - slope * point1.x };
-        return { slope, intercept };
-    };
+    public:
+        MarkerPoseTracker(
+            cv::Ptr<cv::aruco::Dictionary> markerDictionary,
+            cv::Ptr<cv::aruco::DetectorParameters> detectorParameters)
+            : mMarkerDictionary(std::move(markerDictionary))
+            , mDetectorParameters(std::move(detectorParameters))
+        {}
+
+        // Returns false if there is no valid cached pose and no marker is detected
+        bool update(const Zivid::PointCloud &pointCloud)
+        {
+            mNumberOfUpdates++;
+            // The image and the XYZ points are copied once per frame, and shared by the check and the pose estimation
+            const auto grayImage = pointCloudToGray(pointCloud);
+            const auto points = pointCloud.copyPointsXYZ();
 
-    cv::Point2f estimate2DMarkerCenter(const std::vector<cv::Point2f> &markerCorners)
-    {
-        const auto &markerCorner0 = markerCorners[0];
-        const auto &markerCorner1 = markerCorners[1];
-        const auto &markerCorner2 = markerCorners[2];
-        const auto &markerCorner3 = markerCorners[3];
-
-        // Fitting line between two diagonal marker corners
-        const auto backDiagonal{ fitLine(markerCorner2, markerCorner0) };
-        const auto forwardDiagonal{ fitLine(markerCorner3, markerCorner1) };
-
-        // Finding intersection of the two lines
-        // a1*x + b1 = a2*x + b2
-        // x = (b2-b1) / (a1-a2)
-        // y = a1*x + b1
-        const auto xCoordinate =
-            (forwardDiagonal.intercept - backDiagonal.intercept) / (backDiagonal.slope - forwardDiagonal.slope);
-        const auto yCoordinate = backDiagonal.slope * xCoordinate + backDiagonal.intercept;
-        auto markerCenter = cv::Point2f(xCoordinate, yCoordinate);
-
-        return markerCenter;
-    }
+            if(mHasPose && isUnchanged(windowStatistics(grayImage, points)))
+            {
+                return true;
+            }
 
-    std::vector<cv::Point3f> estimate3DMarkerPoints(
-        const Zivid::PointCloud &pointCloud,
-        const std::vector<cv::Point2f> &markerPoints2D)
-    {
-        if(markerPoints2D.empty())
-        {
-            return {};
-        }
+            mNumberOfDetections++;
+            std::vector<int> markerIds;
+            std::vector<std::vector<cv::Point2f>> markerCorners;
+            cv::aruco::detectMarkers(grayImage, mMarkerDictionary, markerCorners, markerIds, mDetectorParameters);
+            if(markerIds.empty())
+            {
+                mHasPose = false;
+                return false;
+            }
 
-        const float width = pointCloud.width();
-        const float height = pointCloud.height();
-        const auto points = pointCloud.copyPointsXYZ();
+            // Robust to NaN pixels at the marker corners, since the corners are found from a plane fit to each marker
+            mMarkerCorners = PoseEstimation::toMarkerCorners(markerCorners);
+            const auto axisCorners = PoseEstimation::MarkerAxisCorners{ 0, 1, 1, 2 };
+            mPose = PoseEstimation::estimateBoardPose(points, mMarkerCorners, axisCorners).pose;
+            mReferenceStatistics = windowStatistics(grayImage, points);
+            mHasPose = true;
+            return true;
+        }
 
-        std::vector<cv::Point3f> markerPoints3D;
-        markerPoints3D.reserve(markerPoints2D.size());
+        const Zivid::Matrix4x4 &pose() const
+        {
+            return mPose;
+        }
 
-        for(const auto &point2D : markerPoints2D)
+        size_t numberOfUpdates() const
         {
-            // Estimating the 3D center/corners of the marker using bilinear interpolation
-            // See https://en.wikipedia.org/wiki/Bilinear_interpolation
-            const auto x = point2D.x;
-            const auto y = point2D.y;
-
-            // Getting pixel coordinates for the four known pixels next to the interpolation point
-            const auto xRoundedDown = clamp(std::floor(x), 0, width - 1);
-            const auto xRoundedUp = clamp(std::ceil(x), 0, width - 1);
-            const auto yRoundedDown = clamp(std::floor(y), 0, height - 1);
-            const auto yRoundedUp = clamp(std::ceil(y), 0, height - 1);
-
-            // Getting 3D coordinates for the four points next to the interpolation point
-            const auto q11 = points(yRoundedDown, xRoundedDown);
-            const auto q12 = points(yRoundedUp, xRoundedDown);
-            const auto q21 = points(yRoundedDown, xRoundedUp);
-            const auto q22 = points(yRoundedUp, xRoundedUp);
-
-            // Linear interpolation in x direction
-            // f(x,y1) = (x2 - x)/(x2 - x1) * f(q11) + (x - x1)/(x2 - x1) * f(q21)
-            const cv::Point3f fxy1{ (xRoundedUp - x) / (xRoundedUp - xRoundedDown) * q11.x
-                                        + (x - xRoundedDown) / (xRoundedUp - xRoundedDown) * q21.x,
-                                    (xRoundedUp - x) / (xRoundedUp - xRoundedDown) * q11.y
-                                        + (x - xRoundedDown) / (xRoundedUp - xRoundedDown) * q21.y,
-                                    (xRoundedUp - x) / (xRoundedUp - xRoundedDown) * q11.z
-                                        + (x - xRoundedDown) / (xRoundedUp - xRoundedDown) * q21.z };
-            // f(x,y2) = (x2 - x)/(x2 - x1) * f(q12) + (x - x1)/(x2 - x1) * f(q22)
-            const cv::Point3f fxy2{ (xRoundedUp - x) / (xRoundedUp - xRoundedDown) * q12.x
-                                        + (x - xRoundedDown) / (xRoundedUp - xRoundedDown) * q22.x,
-                                    (xRoundedUp - x) / (xRoundedUp - xRoundedDown) * q12.y
-                                        + (x - xRoundedDown) / (xRoundedUp - xRoundedDown) * q22.y,
-                                    (xRoundedUp - x) / (xRoundedUp - xRoundedDown) * q12.z
-                                        + (x - xRoundedDown) / (xRoundedUp - xRoundedDown) * q22.z };
-
-            // Linear interpolation in y direction
-            // f(x,y) = (y2 - y)/(y2 - y1) * f(x,y1) + (y - y1)/(y2 - y1) * f(x,y2)
-            markerPoints3D.emplace_back(cv::Point3f{ (yRoundedUp - y) / (yRoundedUp - yRoundedDown) * fxy1.x
-                                                         + (y - yRoundedDown) / (yRoundedUp - yRoundedDown) * fxy2.x,
-                                                     (yRoundedUp - y) / (yRoundedUp - yRoundedDown) * fxy1.y
-                                                         + (y - yRoundedDown) / (yRoundedUp - yRoundedDown) * fxy2.y,
-                                                     (yRoundedUp - y) / (yRoundedUp - yRoundedDown) * fxy1.z
-                                                         + (y - yRoundedDown) / (yRoundedUp - yRoundedDown) * fxy2.z });
+            return mNumberOfUpdates;
         }
 
-        return markerPoints3D;
-    }
+        size_t numberOfDetections() const
+        {
+            return mNumberOfDetections;
+        }
 
-    Zivid::Matrix4x4 transformationMatrix(const cv::Matx33f &rotationMatrix, const cv::Vec3f &translationVector)
-    {
-        auto transformMatrix = Zivid::Matrix4x4{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    private:
+        struct WindowStatistics
+        {
+            float meanIntensity;
+            float meanDepth;
+        };
 
-        for(size_t row = 0; row < rotationMatrix.rows; row++)
+        std::vector<WindowStatistics> windowStatistics(
+            const cv::Mat &grayImage,
+            const Zivid::Array2D<Zivid::PointXYZ> &points) const
         {
-            for(size_t col = 0; col < rotationMatrix.cols; col++)
+            const int windowRadius = 3;
+            const int windowSize = 2 * windowRadius + 1;
+            const auto image = cv::Rect(0, 0, grayImage.cols, grayImage.rows);
+            std::vector<WindowStatistics> statistics;
+            statistics.reserve(static_cast<size_t>(mMarkerCorners.u.size()));
+            for(Eigen::Index i = 0; i < mMarkerCorners.u.size(); i++)
             {
-                transformMatrix(row, col) = rotationMatrix(row, col);
+                const auto topLeft = cv::Point(
+                    static_cast<int>(mMarkerCorners.u(i)) - windowRadius,
+                    static_cast<int>(mMarkerCorners.v(i)) - windowRadius);
+                const auto window = cv::Rect(topLeft, cv::Size(windowSize, windowSize)) & image;
+
+                float intensitySum = 0.F;
+                float depthSum = 0.F;
+                size_t numberOfValidDepths = 0;
+                for(int row = window.y; row < window.y + window.height; row++)
+                {
+                    for(int column = window.x; column < window.x + window.width; column++)
+                    {
+                        intensitySum += static_cast<float>(grayImage.at<uchar>(row, column));
+                        const auto z = points(static_cast<size_t>(row), static_cast<size_t>(column)).z;
+                        if(!std::isnan(z))
+                        {
+                            depthSum += z;
+                            numberOfValidDepths++;
+                        }
+                    }
+                }
+
+                const auto area = static_cast<float>(std::max(1, window.area()));
+                statistics.push_back(WindowStatistics{
+                    intensitySum / area,
+                    numberOfValidDepths > 0 ? depthSum / static_cast<float>(numberOfValidDepths)
+                                            : std::numeric_limits<float>::quiet_NaN() });
             }
+            return statistics;
         }
 
-        transformMatrix(0, 3) = translationVector[0];
-        transformMatrix(1, 3) = translationVector[1];
-        transformMatrix(2, 3) = translationVector[2];
+        bool isUnchanged(const std::vector<WindowStatistics> &statistics) const
+        {
+            const float maxIntensityDifference = 10.F;
+            const float maxDepthDifference = 2.F;
+            for(size_t i = 0; i < statistics.size(); i++)
+            {
+                const auto &reference = mReferenceStatistics[i];
+                if(!(std::abs(statistics[i].meanIntensity - reference.meanIntensity) <= maxIntensityDifference))
+                {
+                    return false;
+                }
+                // A window without valid depth at detection is only compared by intensity. A window that has lost all
+                // its valid depth values since detection has changed, since NaN comparisons are false.
+                if(!std::isnan(reference.meanDepth)
+                   && !(std::abs(statistics[i].meanDepth - reference.meanDepth) <= maxDepthDifference))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
 
-        return transformMatrix;
-    }
+        cv::Ptr<cv::aruco::Dictionary> mMarkerDictionary;
+        cv::Ptr<cv::aruco::DetectorParameters> mDetectorParameters;
+        PoseEstimation::MarkerCorners mMarkerCorners;
+        std::vector<WindowStatistics> mReferenceStatistics;
+        Zivid::Matrix4x4 mPose;
+        bool mHasPose = false;
+        size_t mNumberOfUpdates = 0;
+        size_t mNumberOfDetections = 0;
+    };
 
-    Zivid::Matrix4x4 estimateArUcoMarkerPose(
-        const Zivid::PointCloud &pointCloud,
-        const std::vector<cv::Point2f> &markerCorners)
+    void visualizeZividPointCloud(const Zivid::Frame &frame)
     {
-        // Extracting 2D corners and estimating 2D center
-        const auto center2D = estimate2DMarkerCenter(markerCorners);
-
-        // Estimating 3D corners and center from 2D data
-        const auto corners3D = estimate3DMarkerPoints(pointCloud, markerCorners);
-        const auto center3D = estimate3DMarkerPoints(pointCloud, { center2D })[0];
-
-        // Extracting origin and calculating normal vectors for x-, y- and z-axis
-        const auto origin = cv::Vec3f(center3D.x, center3D.y, center3D.z);
-
-        const auto xAxis = cv::Vec3f(
-            corners3D[1].x - corners3D[0].x, corners3D[1].y - corners3D[0].y, corners3D[1].z - corners3D[0].z);
-
-        const auto yAxis = cv::Vec3f(
-            corners3D[2].x - corners3D[1].x, corners3D[2].y - corners3D[1].y, corners3D[2].z - corners3D[1].z);
-
-        const auto u = xAxis / cv::norm(xAxis, cv::NORM_L2);
-        const auto v = yAxis / cv::norm(yAxis, cv::NORM_L2);
-        const auto normal = u.cross(v);
-        const auto unitNormal = normal / cv::norm(normal, cv::NORM_L2);
+        Zivid::Visualization::Visualizer visualizer;
 
-        auto rotationMatrix = cv::Mat(3, 3, CV_32F);
-        for(int i = 0; i < 3; ++i)
-        {
-            rotationMatrix.at<float>(i, 0) = u[i];
-            rotationMatrix.at<float>(i, 1) = v[i];
-            rotationMatrix.at<float>(i, 2) = unitNormal[i];
-        }
+        visualizer.showMaximized();
+        visualizer.show(frame);
+        visualizer.resetToFit();
 
-        return transformationMatrix(rotationMatrix, origin);
+        std::cout << "Running visualizer. Blocking until window closes." << std::endl;
+        visualizer.run();
     }
 
-    cv::Mat pointCloudToGray(const Zivid::PointCloud &pointCloud)
+    cv::Matx33d zividCameraMatrixToOpenCVCameraMatrix(const Zivid::CameraIntrinsics::CameraMatrix &cameraMatrix)
     {
-        const auto image = pointCloud.copyImageRGBA();
-        const auto rgba = cv::Mat(
-            pointCloud.height(),
-            pointCloud.width(),
-            CV_8UC4,
-            const_cast<void *>(static_cast<const void *>(image.data())));
-        cv::Mat gray;
-        cv::cvtColor(rgba, gray, cv::COLOR_RGBA2GRAY);
-        return gray;
+        return { cameraMatrix.fx().value(),
+                 0.0,
+                 cameraMatrix.cx().value(),
+                 0.0,
+                 cameraMatrix.fy().value(),
+                 cameraMatrix.cy().value(),
+                 0.0,
+                 0.0,
+                 1 };
     }
 
-    std::vector<Eigen::Vector3f> zividToEigen(const std::vector<Zivid::PointXYZ> &zividPoints)
+    std::vector<double> zividDistortionCoefficientsToOpenCVDistortionCoefficients(
+        const Zivid::CameraIntrinsics::Distortion &distortionCoeffs)
     {
-        std::vector<Eigen::Vector3f> eigenPoints(zividPoints.size());
-        for(std::size_t i = 0; i < zividPoints.size(); i++)
-        {
-            eigenPoints[i] = Eigen::Vector3f{ zividPoints[i].x, zividPoints[i].y, zividPoints[i].z };
-        }
-
-        return eigenPoints;
+        return { distortionCoeffs.k1().value(),
+                 distortionCoeffs.k2().value(),
+                 distortionCoeffs.p1().value(),
+                 distortionCoeffs.p2().value(),
+                 distortionCoeffs.k3().value() };
     }
 
-    Eigen::Affine3f zividToEigen(const Zivid::Matrix4x4 &zividMatrix)
+    std::vector<cv::Point3d> roiBoxCorners(const PoseEstimation::ROIBox &box)
     {
-        Eigen::Matrix4f eigenMatrix;
-        for(std::size_t row = 0; row < Zivid::Matrix4x4::rows; row++)
+        const Eigen::Vector3d origin{ box.pointO.x, box.pointO.y, box.pointO.z };
+        const Eigen::Vector3d oa = Eigen::Vector3d{ box.pointA.x, box.pointA.y, box.pointA.z } - origin;
+        const Eigen::Vector3d ob = Eigen::Vector3d{ box.pointB.x, box.pointB.y, box.pointB.z } - origin;
+        const Eigen::Vector3d normal = oa.cross(ob).normalized();
+
+        std::vector<cv::Point3d> corners;
+        for(const auto extent : { box.minExtent, box.maxExtent })
         {
-            for(std::size_t column = 0; column < Zivid::Matrix4x4::cols; column++)
+            for(const auto &baseCorner : { origin, Eigen::Vector3d{ origin + oa }, Eigen::Vector3d{ origin + ob },
+                                           Eigen::Vector3d{ origin + oa + ob } })
             {
-                eigenMatrix(row, column) = zividMatrix(row, column);
+                const Eigen::Vector3d corner = baseCorner + static_cast<double>(extent) * normal;
+                corners.emplace_back(corner.x(), corner.y(), corner.z());
             }
         }
-        Eigen::Affine3f eigenTransform{ eigenMatrix };
-        return eigenTransform;
+        return corners;
     }
 
-    std::vector<Zivid::PointXYZ> eigenToZivid(const std::vector<Eigen::Vector3f> &eigenPoints)
+    // Pixel rectangle that contains the projection of the ROI box, clamped to the image. Only pixels inside this
+    // rectangle can hold points inside the box, so processing can be restricted to it.
+    cv::Rect projectedROIBoxRect(
+        const PoseEstimation::ROIBox &box,
+        const Zivid::CameraIntrinsics &intrinsics,
+        const size_t width,
+        const size_t height)
     {
-        std::vector<Zivid::PointXYZ> zividPoints(eigenPoints.size());
-        for(std::size_t i = 0; i < eigenPoints.size(); i++)
+        const auto image = cv::Rect(0, 0, static_cast<int>(width), static_cast<int>(height));
+        const auto corners = roiBoxCorners(box);
+        if(std::any_of(corners.begin(), corners.end(), [](const cv::Point3d &corner) { return corner.z <= 0.0; }))
         {
-            zividPoints[i] = Zivid::PointXYZ{ eigenPoints[i](0), eigenPoints[i](1), eigenPoints[i](2) };
+            // The box reaches behind the camera, so its projection is unbounded
+            return image;
         }
 
-        return zividPoints;
-    }
-
-    std::vector<Zivid::PointXYZ> transformPoints(
-        const std::vector<Zivid::PointXYZ> &zividPoints,
-        const Zivid::Matrix4x4 &zividTransform)
-    {
-        std::vector<Eigen::Vector3f> eigenPoints = zividToEigen(zividPoints);
-        Eigen::Affine3f eigenTransform = zividToEigen(zividTransform);
-
-        std::vector<Eigen::Vector3f> transformedEigenPoints(eigenPoints.size());
-        for(std::size_t i = 0; i < transformedEigenPoints.size(); i++)
+        std::vector<cv::Point2d> projectedCorners;
+        const cv::Vec3d tvec{ 0, 0, 0 };
+        const cv::Vec3d rvec{ 0, 0, 0 };
+        cv::projectPoints(
+            corners,
+            rvec,
+            tvec,
+            zividCameraMatrixToOpenCVCameraMatrix(intrinsics.cameraMatrix()),
+            zividDistortionCoefficientsToOpenCVDistortionCoefficients(intrinsics.distortion()),
+            projectedCorners);
+
+        auto minCorner = projectedCorners.front();
+        auto maxCorner = projectedCorners.front();
+        for(const auto &corner : projectedCorners)
         {
-            transformedEigenPoints[i] = eigenTransform.rotation() * eigenPoints[i] + eigenTransform.translation();
+            minCorner.x = std::min(minCorner.x, corner.x);
+            minCorner.y = std::min(minCorner.y, corner.y);
+            maxCorner.x = std::max(maxCorner.x, corner.x);
+            maxCorner.y = std::max(maxCorner.y, corner.y);
         }
 
-        std::vector<Zivid::PointXYZ> transformedZividPoints = eigenToZivid(transformedEigenPoints);
-
-        return transformedZividPoints;
-    }
-
-    void visualizeZividPointCloud(const Zivid::Frame &frame)
-    {
-        Zivid::Visualization::Visualizer visualizer;
-
-        visualizer.showMaximized();
-        visualizer.show(frame);
-        visualizer.resetToFit();
-
-        std::cout << "Running visualizer. Blocking until window closes." << std::endl;
-        visualizer.run();
+        // Rounding outwards, so that pixels partly covered by the box are kept
+        const auto topLeft =
+            cv::Point(static_cast<int>(std::floor(minCorner.x)), static_cast<int>(std::floor(minCorner.y)));
+        const auto bottomRight =
+            cv::Point(static_cast<int>(std::ceil(maxCorner.x)) + 1, static_cast<int>(std::ceil(maxCorner.y)) + 1);
+        return cv::Rect(topLeft, bottomRight) & image;
     }
 } // namespace
 
@@ -306,28 +322,34 @@ int main()
 
         std::cout << "Configuring ArUco marker" << std::endl;
         const auto markerDictionary = cv::aruco::getPredefinedDictionary(cv::aruco::DICT_4X4_100);
-        std::vector<int> markerIds;
-        std::vector<std::vector<cv::Point2f>> markerCorners;
         cv::Ptr<cv::aruco::DetectorParameters> detectorParameters = cv::aruco::DetectorParameters::create();
         detectorParameters->cornerRefinementMethod = cv::aruco::CORNER_REFINE_SUBPIX;
+        MarkerPoseTracker markerPoseTracker(markerDictionary, detectorParameters);
 
-        std::cout << "Converting to OpenCV image format" << std::endl;
-        const auto grayImage = pointCloudToGray(pointCloud);
-
-        std::cout << "Detecting ArUco Marker" << std::endl;
-        cv::aruco::detectMarkers(grayImage, markerDictionary, markerCorners, markerIds, detectorParameters);
-
-        if(markerIds.empty())
+        std::cout << "Detecting ArUco Marker and estimating its pose" << std::endl;
+        if(!markerPoseTracker.update(pointCloud))
         {
             std::cout << "No ArUco markers detected" << std::endl;
             return EXIT_FAILURE;
         }
+        const auto transformMarkerToCamera = markerPoseTracker.pose();
 
-        std::cout << "Estimating pose of detected ArUco marker" << std::endl;
-        const auto transformMarkerToCamera = estimateArUcoMarkerPose(pointCloud, markerCorners[0]);
+        std::cout << "Capturing more frames, the marker is only detected again if the area around it has changed"
+                  << std::endl;
+        const size_t numberOfFrames = 5;
+        for(size_t i = 0; i < numberOfFrames; i++)
+        {
+            if(!markerPoseTracker.update(camera.capture(settings).pointCloud()))
+            {
+                std::cout << "Lost the ArUco marker" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        std::cout << "Detected the ArUco marker " << markerPoseTracker.numberOfDetections() << " times for "
+                  << markerPoseTracker.numberOfUpdates() << " frames" << std::endl;
 
         std::cout << "Transforming the ROI base frame points to the camera frame" << std::endl;
-        const auto roiPointsInCameraFrame = transformPoints(
+        const auto roiPointsInCameraFrame = PoseEstimation::transformPoints(
             std::vector<Zivid::PointXYZ>{ pointOInArUcoFrame, pointAInArUcoFrame, pointBInArUcoFrame },
             transformMarkerToCamera);
 
@@ -343,6 +365,31 @@ int main()
 
         std::cout << "Displaying the ROI-filtered point cloud" << std::endl;
         visualizeZividPointCloud(roiFrame);
+
+        std::cout << "Applying the same ROI box to the original point cloud without capturing again" << std::endl;
+        const auto roiBox = PoseEstimation::ROIBox{
+            roiPointsInCameraFrame[0], roiPointsInCameraFrame[1], roiPointsInCameraFrame[2], -10, roiBoxHeight
+        };
+        const auto intrinsics = Zivid::Experimental::Calibration::estimateIntrinsics(originalFrame);
+        const auto pixelRect = projectedROIBoxRect(roiBox, intrinsics, pointCloud.width(), pointCloud.height());
+        std::cout << "The ROI box projects to " << pixelRect.width << "x" << pixelRect.height << " pixels at ("
+                  << pixelRect.x << ", " << pixelRect.y << "), only these pixels are processed" << std::endl;
+        const auto pixelRange = PoseEstimation::PixelRange{ static_cast<size_t>(pixelRect.y),
+                                                            static_cast<size_t>(pixelRect.y + pixelRect.height),
+                                                            static_cast<size_t>(pixelRect.x),
+                                                            static_cast<size_t>(pixelRect.x + pixelRect.width) };
+        const auto roiPoints =
+            PoseEstimation::roiBoxFilter(pointCloud, roiBox, pixelRange, PoseEstimation::ROIFilterOutput::compacted);
+        const auto sdkRoiPoints = PoseEstimation::numberOfValidPoints(roiFrame.pointCloud());
+        std::cout << "Number of points inside the ROI box: " << roiPoints.size() << " (CPU filter), " << sdkRoiPoints
+                  << " (SDK ROI capture)" << std::endl;
+        if(roiPoints.size() != sdkRoiPoints)
+        {
+            std::cout << "Warning: The CPU filter and the SDK ROI differ by "
+                      << (roiPoints.size() > sdkRoiPoints ? roiPoints.size() - sdkRoiPoints
+                                                          : sdkRoiPoints - roiPoints.size())
+                      << " points" << std::endl;
+        }
     }
     catch(const std::exception &e)
     {
@@ -2,20 +2,18 @@
 Filter the point cloud based on a ROI box given relative to the Zivid Calibration Board.
 
 The ZFC file for this sample can be downloaded from https://support.zivid.com/en/latest/api-reference/samples/sample-data.html.
+
+This sample depends on the PoseEstimation library in source/Utilities.
 */
 
 #include <Zivid/Calibration/Detector.h>
 #include <Zivid/Visualization/Visualizer.h>
 #include <Zivid/Zivid.h>
 
-#include <Eigen/Core>
-#include <Eigen/Dense>
-#include <Eigen/Geometry>
+#include <PoseEstimation/PoseEstimation.h>
 
-#include <algorithm>
-#include <cmath>
 #include <iostream>
-#include <thread>
+#include <vector>
 
 namespace
 {
@@ -30,60 +28,6 @@ namespace
         std::cout << "Running visualizer. Blocking until window closes." << std::endl;
         visualizer.run();
     }
-
-    std::vector<Eigen::Vector3f> zividToEigen(const std::vector<Zivid::PointXYZ> &zividPoints)
-    {
-        std::vector<Eigen::Vector3f> eigenPoints(zividPoints.size());
-        for(std::size_t i = 0; i < zividPoints.size(); i++)
-        {
-            eigenPoints[i] = Eigen::Vector3f{ zividPoints[i].x, zividPoints[i].y, zividPoints[i].z };
-        }
-
-        return eigenPoints;
-    }
-
-    Eigen::Affine3f zividToEigen(const Zivid::Matrix4x4 &zividMatrix)
-    {
-        Eigen::Matrix4f eigenMatrix;
-        for(std::size_t row = 0; row < Zivid::Matrix4x4::rows; row++)
-        {
-            for(std::size_t column = 0; column < Zivid::Matrix4x4::cols; column++)
-            {
-                eigenMatrix(row, column) = zividMatrix(row, column);
-            }
-        }
-        Eigen::Affine3f eigenTransform{ eigenMatrix };
-        return eigenTransform;
-    }
-
-    std::vector<Zivid::PointXYZ> eigenToZivid(const std::vector<Eigen::Vector3f> &eigenPoints)
-    {
-        std::vector<Zivid::PointXYZ> zividPoints(eigenPoints.size());
-        for(std::size_t i = 0; i < eigenPoints.size(); i++)
-        {
-            zividPoints[i] = Zivid::PointXYZ{ eigenPoints[i](0), eigenPoints[i](1), eigenPoints[i](2) };
-        }
-
-        return zividPoints;
-    }
-
-    std::vector<Zivid::PointXYZ> transformPoints(
-        const std::vector<Zivid::PointXYZ> &zividPoints,
-        const Zivid::Matrix4x4 &zividTransform)
-    {
-        std::vector<Eigen::Vector3f> eigenPoints = zividToEigen(zividPoints);
-        Eigen::Affine3f affineTransform = zividToEigen(zividTransform);
-
-        std::vector<Eigen::Vector3f> transformedEigenPoints(eigenPoints.size());
-        for(std::size_t i = 0; i < transformedEigenPoints.size(); i++)
-        {
-            transformedEigenPoints[i] = affineTransform.rotation() * eigenPoints[i] + affineTransform.translation();
-        }
-
-        std::vector<Zivid::PointXYZ> transformedZividPoints = eigenToZivid(transformedEigenPoints);
-
-        return transformedZividPoints;
-    }
 } // namespace
 
 int main()
@@ -131,7 +75,7 @@ int main()
         const auto transformCheckerboardToCamera = detectionResult.pose().toMatrix();
 
         std::cout << "Transforming the ROI base frame points to the camera frame" << std::endl;
-        const auto roiPointsInCameraFrame = transformPoints(
+        const auto roiPointsInCameraFrame = PoseEstimation::transformPoints(
             std::vector<Zivid::PointXYZ>{
                 pointOInCheckerboardFrame, pointAInCheckerboardFrame, pointBInCheckerboardFrame },
             transformCheckerboardToCamera);
@@ -148,6 +92,23 @@ int main()
 
         std::cout << "Displaying the ROI-filtered point cloud" << std::endl;
         visualizeZividPointCloud(roiFrame);
+
+        std::cout << "Applying the same ROI box to the original point cloud without capturing again" << std::endl;
+        const auto roiBox = PoseEstimation::ROIBox{
+            roiPointsInCameraFrame[0], roiPointsInCameraFrame[1], roiPointsInCameraFrame[2], -10, roiBoxHeight
+        };
+        const auto roiPoints =
+            PoseEstimation::roiBoxFilter(pointCloud, roiBox, PoseEstimation::ROIFilterOutput::compacted);
+        const auto sdkRoiPoints = PoseEstimation::numberOfValidPoints(roiFrame.pointCloud());
+        std::cout << "Number of points inside the ROI box: " << roiPoints.size() << " (CPU filter), " << sdkRoiPoints
+                  << " (SDK ROI capture)" << std::endl;
+        if(roiPoints.size() != sdkRoiPoints)
+        {
+            std::cout << "Warning: The CPU filter and the SDK ROI differ by "
+                      << (roiPoints.size() > sdkRoiPoints ? roiPoints.size() - sdkRoiPoints
+                                                          : sdkRoiPoints - roiPoints.size())
+                      << " points" << std::endl;
+        }
     }
     catch(const std::exception &e)
     {
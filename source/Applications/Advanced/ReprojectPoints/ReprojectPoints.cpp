@@ -7,22 +7,70 @@ in the camera frame. These points are then passed to the API to get the correspo
 The projector pixel coordinates are then used to draw markers at the correct locations before displaying
 the image using the projector.
 
+The SDK mapping is also sampled once over a 3D grid as a lookup table, which maps points to projector pixels locally
+without a camera round trip. The error of the lookup table against the SDK is reported.
+
+Run with --save-lookup-table to save the lookup table to a file in the current directory, which later runs with the
+same camera, firmware version and intrinsics load instead of sampling again. Run with --evaluate-lookup-table <file> to
+evaluate a saved lookup table without a camera.
+
 Note: This example uses experimental SDK features, which may be modified, moved, or deleted in the future without notice.
 */
 
 #include <Zivid/Application.h>
 #include <Zivid/Exception.h>
+#include <Zivid/Experimental/Calibration.h>
 #include <Zivid/Experimental/Calibration/InfieldCorrection.h>
 #include <Zivid/Projection/Projection.h>
 
 #include <opencv2/opencv.hpp>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace
 {
+    struct Options
+    {
+        bool saveLookupTable;
+        std::string lookupTableToEvaluate;
+    };
+
+    Options readOptions(int argc, char **argv)
+    {
+        Options options{ false, "" };
+        for(int i = 1; i < argc; i++)
+        {
+            const std::string argument = argv[i];
+            if(argument == "--save-lookup-table")
+            {
+                options.saveLookupTable = true;
+            }
+            else if(argument == "--evaluate-lookup-table" && i + 1 < argc)
+            {
+                options.lookupTableToEvaluate = argv[++i];
+            }
+            else
+            {
+                throw std::invalid_argument(
+                    "Unknown argument: " + argument
+                    + ". Usage: ReprojectPoints [--save-lookup-table] [--evaluate-lookup-table <file>]");
+            }
+        }
+        return options;
+    }
+
+
     std::vector<cv::Matx41f> checkerboardGrid()
     {
         std::vector<cv::Matx41f> points;
@@ -54,28 +102,489 @@ namespace
     }
 
 
-    void drawFilledCircles(
-        cv::Mat image,
-        const std::vector<Zivid::PointXY> &positions,
-        int circleSizeInPixels,
-        const cv::Scalar &circleColor)
+    // Composes projector images in a reusable BGRA buffer of the projector resolution. The background is kept as a
+    // cached static layer, and between frames only the areas covered by the previous circles are restored from it.
+    class ProjectorImageComposer
     {
-        for(const auto &position : positions)
+    public:
+        ProjectorImageComposer(const Zivid::Resolution &projectorResolution, const cv::Scalar &backgroundColor)
+            : mResolution{ projectorResolution }
+            , mStaticLayer{ static_cast<int>(projectorResolution.height()),
+                            static_cast<int>(projectorResolution.width()),
+                            CV_8UC4,
+                            backgroundColor }
+            , mImage{ mStaticLayer.clone() }
+        {}
+
+        void drawFilledCircles(
+            const std::vector<Zivid::PointXY> &positions,
+            int circleSizeInPixels,
+            const cv::Scalar &circleColor)
         {
-            if(!std::isnan(position.x) && !std::isnan(position.y))
+            for(const auto &area : mDirtyAreas)
             {
-                const cv::Point point(position.x, position.y);
-                cv::circle(image, point, circleSizeInPixels, circleColor, -1);
+                auto destination = mImage(area);
+                mStaticLayer(area).copyTo(destination);
+            }
+            mDirtyAreas.clear();
+
+            const cv::Rect imageArea{ 0, 0, mImage.cols, mImage.rows };
+            const auto areaSize = 2 * circleSizeInPixels + 3;
+            for(const auto &position : positions)
+            {
+                if(!std::isnan(position.x) && !std::isnan(position.y))
+                {
+                    const cv::Point point(position.x, position.y);
+                    cv::circle(mImage, point, circleSizeInPixels, circleColor, -1);
+
+                    const auto area = cv::Rect{ point.x - circleSizeInPixels - 1,
+                                                point.y - circleSizeInPixels - 1,
+                                                areaSize,
+                                                areaSize }
+                                      & imageArea;
+                    if(!area.empty())
+                    {
+                        mDirtyAreas.push_back(area);
+                    }
+                }
             }
         }
+
+        Zivid::Image<Zivid::ColorBGRA> image() const
+        {
+            // The SDK image owns its pixels, so the composed buffer is copied once here
+            return Zivid::Image<Zivid::ColorBGRA>{ mResolution, mImage.datastart, mImage.dataend };
+        }
+
+    private:
+        Zivid::Resolution mResolution;
+        cv::Mat mStaticLayer;
+        cv::Mat mImage;
+        std::vector<cv::Rect> mDirtyAreas;
+    };
+
+
+    // The lookup table is sampled in normalized camera coordinates (x / z, y / z) and inverse depth (1 / z), in which
+    // the mapping to projector pixels is close to linear
+    struct LookupTableGrid
+    {
+        std::array<int32_t, 3> size;
+        std::array<float, 3> min;
+        std::array<float, 3> max;
+    };
+
+
+    // The camera a lookup table was sampled with. The SDK does not expose the projector calibration, so the camera
+    // intrinsics stand in for it. They change when the camera is recalibrated, but may not change with an update that
+    // only affects the projector, so delete the saved lookup table after such an update.
+    struct LookupTableIdentity
+    {
+        std::string serialNumber;
+        std::string firmwareVersion;
+        std::string calibration;
+    };
+
+    LookupTableIdentity lookupTableIdentity(const Zivid::Camera &camera)
+    {
+        const auto info = camera.info();
+        return LookupTableIdentity{ info.serialNumber().toString(),
+                                    info.firmwareVersion().toString(),
+                                    Zivid::Experimental::Calibration::intrinsics(camera).toString() };
+    }
+
+    bool isSameIdentity(const LookupTableIdentity &identity1, const LookupTableIdentity &identity2)
+    {
+        return identity1.serialNumber == identity2.serialNumber
+               && identity1.firmwareVersion == identity2.firmwareVersion
+               && identity1.calibration == identity2.calibration;
+    }
+
+
+    // Lookup table files start with this tag and version. Increase the version when the file layout or the grid
+    // parameterization changes, so that older files are rejected instead of being misread.
+    const std::array<char, 4> lookupTableFileTag{ { 'Z', 'P', 'L', 'T' } };
+    const uint32_t lookupTableFileVersion = 1;
+
+    template<typename T>
+    void writeValue(std::ofstream &file, const T &value)
+    {
+        file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    template<typename T>
+    void readValue(std::ifstream &file, T &value)
+    {
+        file.read(reinterpret_cast<char *>(&value), sizeof(value));
+    }
+
+    void writeString(std::ofstream &file, const std::string &value)
+    {
+        writeValue(file, static_cast<uint32_t>(value.size()));
+        file.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+
+    std::string readString(std::ifstream &file)
+    {
+        uint32_t size = 0;
+        readValue(file, size);
+        // Guards against allocating for the length read from a corrupt file
+        const uint32_t maxSize = 1 << 20;
+        if(!file || size > maxSize)
+        {
+            file.setstate(std::ios::failbit);
+            return "";
+        }
+        std::string value(size, '\0');
+        file.read(&value[0], static_cast<std::streamsize>(size));
+        return value;
+    }
+
+
+    // Maps 3D points in the camera frame to projector pixels by trilinear interpolation in a lookup table sampled with
+    // the SDK. Points outside the sampled volume, or near grid points the projector does not reach, map to NaN.
+    class ProjectorPixelLookupTable
+    {
+    public:
+        ProjectorPixelLookupTable(const Zivid::Camera &camera, const LookupTableGrid &grid)
+            : mIdentity{ lookupTableIdentity(camera) }
+            , mGrid{ grid }
+        {
+            if(std::any_of(grid.size.begin(), grid.size.end(), [](int32_t size) { return size < 2; }))
+            {
+                throw std::invalid_argument("The lookup table needs at least 2 grid points along each axis");
+            }
+
+            const auto projectorPixels = Zivid::Projection::pixelsFrom3DPoints(camera, gridPoints());
+            mPixelsX.reserve(projectorPixels.size());
+            mPixelsY.reserve(projectorPixels.size());
+            for(const auto &pixel : projectorPixels)
+            {
+                mPixelsX.push_back(pixel.x);
+                mPixelsY.push_back(pixel.y);
+            }
+        }
+
+        explicit ProjectorPixelLookupTable(const std::string &fileName)
+        {
+            std::ifstream file(fileName, std::ios::binary);
+            std::array<char, 4> tag{};
+            uint32_t version = 0;
+            readValue(file, tag);
+            readValue(file, version);
+            if(!file || tag != lookupTableFileTag)
+            {
+                throw std::runtime_error("Not a projector pixel lookup table file: " + fileName);
+            }
+            if(version != lookupTableFileVersion)
+            {
+                throw std::runtime_error(
+                    "Projector pixel lookup table file has version " + std::to_string(version) + ", expected "
+                    + std::to_string(lookupTableFileVersion) + ": " + fileName);
+            }
+
+            mIdentity.serialNumber = readString(file);
+            mIdentity.firmwareVersion = readString(file);
+            mIdentity.calibration = readString(file);
+            readValue(file, mGrid.size);
+            readValue(file, mGrid.min);
+            readValue(file, mGrid.max);
+            if(!file || std::any_of(mGrid.size.begin(), mGrid.size.end(), [](int32_t size) { return size < 2; }))
+            {
+                throw std::runtime_error("Failed to load projector pixel lookup table from file: " + fileName);
+            }
+
+            mPixelsX.resize(numberOfGridPoints());
+            mPixelsY.resize(numberOfGridPoints());
+            for(auto *pixels : { &mPixelsX, &mPixelsY })
+            {
+                file.read(
+                    reinterpret_cast<char *>(pixels->data()),
+                    static_cast<std::streamsize>(pixels->size() * sizeof(float)));
+            }
+            if(!file || file.peek() != std::ifstream::traits_type::eof())
+            {
+                throw std::runtime_error("Failed to load projector pixel lookup table from file: " + fileName);
+            }
+        }
+
+        void save(const std::string &fileName) const
+        {
+            std::ofstream file(fileName, std::ios::binary);
+            writeValue(file, lookupTableFileTag);
+            writeValue(file, lookupTableFileVersion);
+            writeString(file, mIdentity.serialNumber);
+            writeString(file, mIdentity.firmwareVersion);
+            writeString(file, mIdentity.calibration);
+            writeValue(file, mGrid.size);
+            writeValue(file, mGrid.min);
+            writeValue(file, mGrid.max);
+            for(const auto *pixels : { &mPixelsX, &mPixelsY })
+            {
+                file.write(
+                    reinterpret_cast<const char *>(pixels->data()),
+                    static_cast<std::streamsize>(pixels->size() * sizeof(float)));
+            }
+            if(!file)
+            {
+                throw std::runtime_error("Failed to save projector pixel lookup table to file: " + fileName);
+            }
+        }
+
+        const LookupTableIdentity &identity() const
+        {
+            return mIdentity;
+        }
+
+        // Batch evaluation into separate x and y arrays. The table lookups are gathers from data dependent cells, so
+        // the loop is not vectorized, but it needs no SDK call and the table fits in the CPU cache.
+        void pixelsFrom3DPoints(const Zivid::PointXYZ *points, size_t count, float *pixelsX, float *pixelsY) const
+        {
+            const auto nan = std::numeric_limits<float>::quiet_NaN();
+            const auto sizeX = mGrid.size[0];
+            const auto sizeY = mGrid.size[1];
+            const auto sizeZ = mGrid.size[2];
+            const auto scaleX = static_cast<float>(sizeX - 1) / (mGrid.max[0] - mGrid.min[0]);
+            const auto scaleY = static_cast<float>(sizeY - 1) / (mGrid.max[1] - mGrid.min[1]);
+            const auto scaleZ = static_cast<float>(sizeZ - 1) / (mGrid.max[2] - mGrid.min[2]);
+            const auto strideY = static_cast<size_t>(sizeX);
+            const auto strideZ = static_cast<size_t>(sizeX) * static_cast<size_t>(sizeY);
+            const auto *tableX = mPixelsX.data();
+            const auto *tableY = mPixelsY.data();
+
+            for(size_t i = 0; i < count; i++)
+            {
+                const auto inverseDepth = 1.F / points[i].z;
+                const auto gridX = (points[i].x * inverseDepth - mGrid.min[0]) * scaleX;
+                const auto gridY = (points[i].y * inverseDepth - mGrid.min[1]) * scaleY;
+                const auto gridZ = (inverseDepth - mGrid.min[2]) * scaleZ;
+
+                // Written so that NaN coordinates also fail the check
+                const auto isInside = gridX >= 0.F && gridX <= static_cast<float>(sizeX - 1) && gridY >= 0.F
+                                      && gridY <= static_cast<float>(sizeY - 1) && gridZ >= 0.F
+                                      && gridZ <= static_cast<float>(sizeZ - 1);
+                if(!isInside)
+                {
+                    pixelsX[i] = nan;
+                    pixelsY[i] = nan;
+                    continue;
+                }
+
+                const auto indexX = std::min(static_cast<int32_t>(gridX), sizeX - 2);
+                const auto indexY = std::min(static_cast<int32_t>(gridY), sizeY - 2);
+                const auto indexZ = std::min(static_cast<int32_t>(gridZ), sizeZ - 2);
+                const auto fx = gridX - static_cast<float>(indexX);
+                const auto fy = gridY - static_cast<float>(indexY);
+                const auto fz = gridZ - static_cast<float>(indexZ);
+
+                const auto index = static_cast<size_t>(indexZ) * strideZ + static_cast<size_t>(indexY) * strideY
+                                   + static_cast<size_t>(indexX);
+                pixelsX[i] = trilinear(tableX + index, strideY, strideZ, fx, fy, fz);
+                pixelsY[i] = trilinear(tableY + index, strideY, strideZ, fx, fy, fz);
+            }
+        }
+
+        std::vector<Zivid::PointXY> pixelsFrom3DPoints(const std::vector<Zivid::PointXYZ> &points) const
+        {
+            std::vector<float> pixelsX(points.size());
+            std::vector<float> pixelsY(points.size());
+            pixelsFrom3DPoints(points.data(), points.size(), pixelsX.data(), pixelsY.data());
+
+            std::vector<Zivid::PointXY> pixels;
+            pixels.reserve(points.size());
+            for(size_t i = 0; i < points.size(); i++)
+            {
+                pixels.emplace_back(pixelsX[i], pixelsY[i]);
+            }
+            return pixels;
+        }
+
+    private:
+        static float trilinear(const float *corner, size_t strideY, size_t strideZ, float fx, float fy, float fz)
+        {
+            const auto lerp = [](float a, float b, float t) { return a + (b - a) * t; };
+            const auto *back = corner + strideZ;
+            const auto frontValue =
+                lerp(lerp(corner[0], corner[1], fx), lerp(corner[strideY], corner[strideY + 1], fx), fy);
+            const auto backValue = lerp(lerp(back[0], back[1], fx), lerp(back[strideY], back[strideY + 1], fx), fy);
+            return lerp(frontValue, backValue, fz);
+        }
+
+        size_t numberOfGridPoints() const
+        {
+            return static_cast<size_t>(mGrid.size[0]) * static_cast<size_t>(mGrid.size[1])
+                   * static_cast<size_t>(mGrid.size[2]);
+        }
+
+        float gridValue(size_t axis, int32_t index) const
+        {
+            return mGrid.min[axis]
+                   + (mGrid.max[axis] - mGrid.min[axis]) * static_cast<float>(index)
+                         / static_cast<float>(mGrid.size[axis] - 1);
+        }
+
+        std::vector<Zivid::PointXYZ> gridPoints() const
+        {
+            std::vector<Zivid::PointXYZ> points;
+            points.reserve(numberOfGridPoints());
+            for(int32_t z = 0; z < mGrid.size[2]; z++)
+            {
+                const auto depth = 1.F / gridValue(2, z);
+                for(int32_t y = 0; y < mGrid.size[1]; y++)
+                {
+                    for(int32_t x = 0; x < mGrid.size[0]; x++)
+                    {
+                        points.emplace_back(gridValue(0, x) * depth, gridValue(1, y) * depth, depth);
+                    }
+                }
+            }
+            return points;
+        }
+
+        LookupTableIdentity mIdentity;
+        LookupTableGrid mGrid{};
+        std::vector<float> mPixelsX;
+        std::vector<float> mPixelsY;
+    };
+
+
+    // Samples the lookup table, or if persistToDisk is set, loads it from a file saved by an earlier run. A saved
+    // lookup table that was sampled with another firmware version or calibration is sampled again and overwritten.
+    ProjectorPixelLookupTable loadOrSampleLookupTable(const Zivid::Camera &camera, const bool persistToDisk)
+    {
+        const auto identity = lookupTableIdentity(camera);
+        const auto fileName = "ProjectorPixelLookupTable_" + identity.serialNumber + ".bin";
+        if(persistToDisk && std::ifstream(fileName).good())
+        {
+            std::cout << "Loading projector pixel lookup table from file: " << fileName << std::endl;
+            try
+            {
+                ProjectorPixelLookupTable savedLookupTable{ fileName };
+                if(isSameIdentity(savedLookupTable.identity(), identity))
+                {
+                    return savedLookupTable;
+                }
+                std::cout << "The saved lookup table was sampled with another firmware version or calibration"
+                          << std::endl;
+            }
+            catch(const std::runtime_error &e)
+            {
+                std::cout << "Ignoring the saved lookup table: " << e.what() << std::endl;
+            }
+        }
+
+        // Covers the field of view of the cameras at working distances from 250 mm to 3000 mm
+        const LookupTableGrid grid{ { { 49, 41, 16 } },
+                                    { { -0.6F, -0.5F, 1.F / 3000.F } },
+                                    { { 0.6F, 0.5F, 1.F / 250.F } } };
+
+        std::cout << "Sampling projector pixels of a 3D grid to build the lookup table" << std::endl;
+        const ProjectorPixelLookupTable lookupTable{ camera, grid };
+        if(persistToDisk)
+        {
+            std::cout << "Saving projector pixel lookup table to file: " << fileName << std::endl;
+            lookupTable.save(fileName);
+        }
+        return lookupTable;
+    }
+
+
+    void printLookupTableError(
+        const std::vector<Zivid::PointXY> &sdkPixels,
+        const std::vector<Zivid::PointXY> &lookupTablePixels)
+    {
+        size_t numberOfCompared = 0;
+        size_t numberOfMismatchedValidity = 0;
+        double sumOfErrors = 0.0;
+        double maxError = 0.0;
+        for(size_t i = 0; i < sdkPixels.size(); i++)
+        {
+            const auto isSdkValid = !std::isnan(sdkPixels[i].x) && !std::isnan(sdkPixels[i].y);
+            const auto isLookupTableValid = !std::isnan(lookupTablePixels[i].x) && !std::isnan(lookupTablePixels[i].y);
+            if(isSdkValid != isLookupTableValid)
+            {
+                numberOfMismatchedValidity++;
+            }
+            else if(isSdkValid)
+            {
+                const auto error = std::hypot(
+                    static_cast<double>(sdkPixels[i].x - lookupTablePixels[i].x),
+                    static_cast<double>(sdkPixels[i].y - lookupTablePixels[i].y));
+                sumOfErrors += error;
+                maxError = std::max(maxError, error);
+                numberOfCompared++;
+            }
+        }
+
+        std::cout << "Lookup table error against the SDK over " << numberOfCompared << " points: mean "
+                  << (numberOfCompared > 0 ? sumOfErrors / static_cast<double>(numberOfCompared) : 0.0)
+                  << " pixels, max " << maxError << " pixels" << std::endl;
+        if(numberOfMismatchedValidity > 0)
+        {
+            std::cout << numberOfMismatchedValidity << " points are only projectable by one of the two" << std::endl;
+        }
+    }
+
+
+    // Evaluates a saved lookup table without a camera, on the checkerboard grid facing the camera at a few working
+    // distances. There is no SDK mapping to compare against, so only the projectable points and the time are reported.
+    void evaluateSavedLookupTable(const std::string &fileName)
+    {
+        std::cout << "Loading projector pixel lookup table from file: " << fileName << std::endl;
+        const ProjectorPixelLookupTable lookupTable{ fileName };
+        std::cout << "The lookup table was sampled with camera " << lookupTable.identity().serialNumber
+                  << " and firmware version " << lookupTable.identity().firmwareVersion << std::endl;
+
+        const auto grid = checkerboardGrid();
+        std::vector<Zivid::PointXYZ> points;
+        for(const auto distance : { 500.F, 1000.F, 1500.F })
+        {
+            // The 180 mm x 150 mm grid centered on the optical axis
+            const Zivid::Matrix4x4 transformCameraToCheckerboard{ { 1.F, 0.F, 0.F, -90.F },
+                                                                  { 0.F, 1.F, 0.F, -75.F },
+                                                                  { 0.F, 0.F, 1.F, distance },
+                                                                  { 0.F, 0.F, 0.F, 1.F } };
+            const auto boardPoints = transformGridToCalibrationBoard(grid, transformCameraToCheckerboard);
+            const auto pixels = lookupTable.pixelsFrom3DPoints(boardPoints);
+            const auto numberOfProjectable =
+                std::count_if(pixels.begin(), pixels.end(), [](const Zivid::PointXY &pixel) {
+                    return !std::isnan(pixel.x) && !std::isnan(pixel.y);
+                });
+            std::cout << "Checkerboard at " << distance << " mm: " << numberOfProjectable << " of " << pixels.size()
+                      << " points are projectable, the first at projector pixel (" << pixels.front().x << ", "
+                      << pixels.front().y << ")" << std::endl;
+            points.insert(points.end(), boardPoints.begin(), boardPoints.end());
+        }
+
+        const size_t numberOfRepetitions = 1000;
+        std::vector<Zivid::PointXYZ> batch;
+        batch.reserve(numberOfRepetitions * points.size());
+        for(size_t i = 0; i < numberOfRepetitions; i++)
+        {
+            batch.insert(batch.end(), points.begin(), points.end());
+        }
+        std::vector<float> pixelsX(batch.size());
+        std::vector<float> pixelsY(batch.size());
+        const auto start = std::chrono::steady_clock::now();
+        lookupTable.pixelsFrom3DPoints(batch.data(), batch.size(), pixelsX.data(), pixelsY.data());
+        const auto duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        std::cout << "Getting projector pixels of " << batch.size() << " points took " << duration.count()
+                  << " ms with the lookup table" << std::endl;
     }
 
 } // namespace
 
-int main()
+int main(int argc, char **argv)
 {
     try
     {
+        const auto options = readOptions(argc, argv);
+        if(!options.lookupTableToEvaluate.empty())
+        {
+            evaluateSavedLookupTable(options.lookupTableToEvaluate);
+            std::cout << "Done" << std::endl;
+            return EXIT_SUCCESS;
+        }
+
         Zivid::Application zivid;
 
         std::cout << "Connecting to camera" << std::endl;
@@ -100,27 +609,33 @@ int main()
         const auto pointsInCameraFrame = transformGridToCalibrationBoard(grid, transformCameraToCheckerboard);
 
         std::cout << "Getting projector pixels (2D) corresponding to points (3D) in the camera frame" << std::endl;
+        const auto sdkStart = std::chrono::steady_clock::now();
         const auto projectorPixels = Zivid::Projection::pixelsFrom3DPoints(camera, pointsInCameraFrame);
+        const auto sdkDuration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sdkStart);
+
+        const auto lookupTable = loadOrSampleLookupTable(camera, options.saveLookupTable);
+        const auto lookupTableStart = std::chrono::steady_clock::now();
+        const auto lookupTablePixels = lookupTable.pixelsFrom3DPoints(pointsInCameraFrame);
+        const auto lookupTableDuration =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lookupTableStart);
+        std::cout << "Getting projector pixels took " << sdkDuration.count() << " ms with the SDK and "
+                  << lookupTableDuration.count() << " ms with the lookup table" << std::endl;
+        printLookupTableError(projectorPixels, lookupTablePixels);
 
         std::cout << "Retrieving the projector resolution that the camera supports" << std::endl;
         const auto projectorResolution = Zivid::Projection::projectorResolution(camera);
 
-        std::cout << "Creating a blank projector image with resolution: " << projectorResolution.toString()
+        std::cout << "Creating a projector image composer with resolution: " << projectorResolution.toString()
                   << std::endl;
         const cv::Scalar backgroundColor{ 0, 0, 0, 255 };
-        auto projectorImageOpenCV = cv::Mat{ static_cast<int>(projectorResolution.height()),
-                                             static_cast<int>(projectorResolution.width()),
-                                             CV_8UC4,
-                                             backgroundColor };
+        ProjectorImageComposer projectorImageComposer{ projectorResolution, backgroundColor };
 
         std::cout << "Drawing circles on the projector image for each grid point" << std::endl;
         const cv::Scalar circleColor{ 0, 255, 0, 255 };
-        drawFilledCircles(projectorImageOpenCV, projectorPixels, 2, circleColor);
+        projectorImageComposer.drawFilledCircles(projectorPixels, 2, circleColor);
 
-        std::cout << "Creating a Zivid::Image from the OpenCV image" << std::endl;
-        const Zivid::Image<Zivid::ColorBGRA> projectorImage{ projectorResolution,
-                                                             projectorImageOpenCV.datastart,
-                                                             projectorImageOpenCV.dataend };
+        std::cout << "Creating a Zivid::Image from the composed projector image" << std::endl;
+        const auto projectorImage = projectorImageComposer.image();
 
         const std::string projectorImageFile = "ProjectorImage.png";
         std::cout << "Saving the projector image to file: " << projectorImageFile << std::endl;
@@ -5,13 +5,17 @@ Capture point clouds, with color, from the Zivid camera, save it to PCD file for
 #include <Zivid/Visualization/Visualizer.h>
 #include <Zivid/Zivid.h>
 
-#include <pcl/io/pcd_io.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 #include <pcl/visualization/cloud_viewer.h>
 
+#include <cstdint>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <vector>
 
 namespace
 {
@@ -94,15 +98,73 @@ namespace
     }
 
     template<typename T>
-    void visualizeAndSavePointCloudPCL(const pcl::PointCloud<T> &pointCloud)
+    void appendBinary(std::vector<char> &buffer, const T &value)
     {
-        std::cout << "Visualizing PCL point cloud" << std::endl;
-        visualizePointCloudPCL(pointCloud);
+        const auto *bytes = reinterpret_cast<const char *>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
 
-        std::string pointCloudFile = "Zivid3D.pcd";
-        std::cout << "Saving point cloud to file: " << pointCloudFile << std::endl;
-        pcl::io::savePCDFileBinary(pointCloudFile, pointCloud);
-        std::cerr << "Saved " << pointCloud.points.size() << " points" << std::endl;
+    // Writes the point cloud directly from the Zivid data to a binary PCD file, with the same fields as PCL writes for
+    // pcl::PointXYZRGB and pcl::PointXYZRGBNormal, without first converting to a PCL point cloud. The curvature field
+    // of pcl::PointXYZRGBNormal is written as 0, since the Zivid point cloud has no curvature.
+    void savePCDFileBinary(
+        const std::string &fileName,
+        const Zivid::Array2D<Zivid::PointXYZColorRGBA> &data,
+        const Zivid::Array2D<Zivid::NormalXYZ> *normals)
+    {
+        std::ofstream file(fileName, std::ios::binary);
+        if(!file)
+        {
+            throw std::runtime_error("Failed to open file: " + fileName);
+        }
+
+        const bool withNormals = normals != nullptr;
+        file << "# .PCD v0.7 - Point Cloud Data file format\n"
+             << "VERSION 0.7\n"
+             << "FIELDS x y z rgb" << (withNormals ? " normal_x normal_y normal_z curvature" : "") << "\n"
+             << "SIZE 4 4 4 4" << (withNormals ? " 4 4 4 4" : "") << "\n"
+             << "TYPE F F F F" << (withNormals ? " F F F F" : "") << "\n"
+             << "COUNT 1 1 1 1" << (withNormals ? " 1 1 1 1" : "") << "\n"
+             << "WIDTH " << data.width() << "\n"
+             << "HEIGHT " << data.height() << "\n"
+             << "VIEWPOINT 0 0 0 1 0 0 0\n"
+             << "POINTS " << data.size() << "\n"
+             << "DATA binary\n";
+
+        // Each row is serialized into a buffer and written in one go
+        const size_t pointSize = (withNormals ? 8 : 4) * sizeof(float);
+        std::vector<char> row;
+        row.reserve(data.width() * pointSize);
+        for(size_t i = 0; i < data.height(); i++)
+        {
+            row.clear();
+            for(size_t j = 0; j < data.width(); j++)
+            {
+                const auto &p = data(i, j);
+                const std::uint32_t rgb = (static_cast<std::uint32_t>(p.color.r) << 16U)
+                                          | (static_cast<std::uint32_t>(p.color.g) << 8U)
+                                          | static_cast<std::uint32_t>(p.color.b);
+                appendBinary(row, p.point.x);
+                appendBinary(row, p.point.y);
+                appendBinary(row, p.point.z);
+                appendBinary(row, rgb);
+                if(withNormals)
+                {
+                    const auto &normal = (*normals)(i, j);
+                    appendBinary(row, normal.x);
+                    appendBinary(row, normal.y);
+                    appendBinary(row, normal.z);
+                    appendBinary(row, 0.F);
+                }
+            }
+            file.write(row.data(), static_cast<std::streamsize>(row.size()));
+        }
+
+        if(!file)
+        {
+            throw std::runtime_error("Failed to write file: " + fileName);
+        }
+        std::cerr << "Saved " << data.size() << " points" << std::endl;
     }
 
 } // namespace
@@ -127,6 +189,7 @@ int main(int argc, char **argv)
         const auto pointCloud = frame.pointCloud();
         const auto data = pointCloud.copyData<Zivid::PointXYZColorRGBA>();
 
+        const std::string pointCloudFile = "Zivid3D.pcd";
         if(useNormals)
         {
             std::cout << "Computing point cloud normals" << std::endl;
@@ -135,14 +198,22 @@ int main(int argc, char **argv)
             std::cout << "Converting Zivid point cloud with normals to PCL format" << std::endl;
             const auto pointCloudWithNormalsPCL = convertToPCLPointCloud(data, normals);
 
-            visualizeAndSavePointCloudPCL(pointCloudWithNormalsPCL);
+            std::cout << "Visualizing PCL point cloud" << std::endl;
+            visualizePointCloudPCL(pointCloudWithNormalsPCL);
+
+            std::cout << "Saving point cloud to file: " << pointCloudFile << std::endl;
+            savePCDFileBinary(pointCloudFile, data, &normals);
         }
         else
         {
             std::cout << "Converting Zivid point cloud to PCL format" << std::endl;
             const auto pointCloudPCL = convertToPCLPointCloud(data);
 
-            visualizeAndSavePointCloudPCL(pointCloudPCL);
+            std::cout << "Visualizing PCL point cloud" << std::endl;
+            visualizePointCloudPCL(pointCloudPCL);
+
+            std::cout << "Saving point cloud to file: " << pointCloudFile << std::endl;
+            savePCDFileBinary(pointCloudFile, data, nullptr);
         }
     }
     catch(const std::exception &e)
@@ -0,0 +1,466 @@
+#include "PoseEstimation/PoseEstimation.h"
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace PoseEstimation
+{
+    namespace
+    {
+        // Pixel coordinates (u, v, 1) and 3D points of the valid pixels inside a marker, one column per pixel
+        struct MarkerSamples
+        {
+            Eigen::Matrix3Xf pixels;
+            Eigen::Matrix3Xf points;
+        };
+
+        struct PlaneFit
+        {
+            Eigen::Vector3f centroid;
+            Eigen::Vector3f normal;
+            Eigen::VectorXf weights;
+            float rmsResidual;
+        };
+
+        bool isInsideMarker(const MarkerCorners &corners, const Eigen::Index marker, const float u, const float v)
+        {
+            // Inside a convex quadrilateral, the point is on the same side of all four edges
+            auto hasPositive = false;
+            auto hasNegative = false;
+            for(Eigen::Index i = 0; i < 4; i++)
+            {
+                const auto j = (i + 1) % 4;
+                const auto cross = (corners.u(j, marker) - corners.u(i, marker)) * (v - corners.v(i, marker))
+                                   - (corners.v(j, marker) - corners.v(i, marker)) * (u - corners.u(i, marker));
+                hasPositive = hasPositive || cross > 0.F;
+                hasNegative = hasNegative || cross < 0.F;
+            }
+            return !(hasPositive && hasNegative);
+        }
+
+        MarkerSamples markerSamples(
+            const Zivid::PointXYZ *points,
+            const size_t width,
+            const size_t height,
+            const MarkerCorners &corners,
+            const Eigen::Index marker)
+        {
+            const auto minU = corners.u.col(marker).minCoeff();
+            const auto minV = corners.v.col(marker).minCoeff();
+            const auto maxU = corners.u.col(marker).maxCoeff();
+            const auto maxV = corners.v.col(marker).maxCoeff();
+            const auto beginColumn = static_cast<size_t>(std::max(0.F, std::floor(minU)));
+            const auto beginRow = static_cast<size_t>(std::max(0.F, std::floor(minV)));
+            const auto endColumn = std::min(width, static_cast<size_t>(std::max(0.F, std::ceil(maxU))) + 1);
+            const auto endRow = std::min(height, static_cast<size_t>(std::max(0.F, std::ceil(maxV))) + 1);
+
+            std::vector<float> pixels;
+            std::vector<float> xyz;
+            for(size_t row = beginRow; row < endRow; row++)
+            {
+                for(size_t column = beginColumn; column < endColumn; column++)
+                {
+                    const auto u = static_cast<float>(column);
+                    const auto v = static_cast<float>(row);
+                    const auto &point = points[row * width + column];
+                    if(!point.isNaN() && isInsideMarker(corners, marker, u, v))
+                    {
+                        pixels.insert(pixels.end(), { u, v, 1.F });
+                        xyz.insert(xyz.end(), { point.x, point.y, point.z });
+                    }
+                }
+            }
+
+            const auto numberOfSamples = static_cast<Eigen::Index>(xyz.size() / 3);
+            return { Eigen::Map<const Eigen::Matrix3Xf>(pixels.data(), 3, numberOfSamples),
+                     Eigen::Map<const Eigen::Matrix3Xf>(xyz.data(), 3, numberOfSamples) };
+        }
+
+        Eigen::VectorXf
+            planeResiduals(const Eigen::Matrix3Xf &points, const Eigen::Vector3f &point, const Eigen::Vector3f &normal)
+        {
+            return (normal.transpose() * (points.colwise() - point)).transpose().cwiseAbs();
+        }
+
+        // Fits a plane robustly. RANSAC over point triplets gives a starting plane that outliers cannot pull away,
+        // which is then refined by iteratively reweighted least squares with Huber weights.
+        PlaneFit fitPlane(const Eigen::Matrix3Xf &points)
+        {
+            const float inlierThreshold = 1.F;
+            const int numberOfRansacIterations = 50;
+            const int numberOfRefinementIterations = 5;
+
+            PlaneFit fit{ points.col(0), Eigen::Vector3f::UnitZ(), Eigen::VectorXf::Ones(points.cols()), 0.F };
+
+            std::minstd_rand generator(0);
+            std::uniform_int_distribution<Eigen::Index> randomIndex(0, points.cols() - 1);
+            Eigen::Index maxNumberOfInliers = -1;
+            for(int iteration = 0; iteration < numberOfRansacIterations; iteration++)
+            {
+                const Eigen::Vector3f point0 = points.col(randomIndex(generator));
+                const Eigen::Vector3f point1 = points.col(randomIndex(generator));
+                const Eigen::Vector3f point2 = points.col(randomIndex(generator));
+                const Eigen::Vector3f normal = (point1 - point0).cross(point2 - point0);
+                if(normal.norm() < 1e-6F)
+                {
+                    continue;
+                }
+                const auto numberOfInliers =
+                    (planeResiduals(points, point0, normal.normalized()).array() < inlierThreshold).count();
+                if(numberOfInliers > maxNumberOfInliers)
+                {
+                    maxNumberOfInliers = numberOfInliers;
+                    fit.centroid = point0;
+                    fit.normal = normal.normalized();
+                }
+            }
+
+            for(int iteration = 0; iteration < numberOfRefinementIterations; iteration++)
+            {
+                fit.weights =
+                    planeResiduals(points, fit.centroid, fit.normal).unaryExpr([inlierThreshold](const float r) {
+                        return r <= inlierThreshold ? 1.F : inlierThreshold / r;
+                    });
+                fit.centroid = points * fit.weights / fit.weights.sum();
+                const Eigen::Matrix3Xf centered = points.colwise() - fit.centroid;
+                const Eigen::Matrix3f covariance = centered * fit.weights.asDiagonal() * centered.transpose();
+                const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> solver(covariance);
+                fit.normal = solver.eigenvectors().col(0);
+            }
+
+            const Eigen::VectorXf residuals = planeResiduals(points, fit.centroid, fit.normal);
+            fit.rmsResidual = std::sqrt(residuals.cwiseAbs2().dot(fit.weights) / fit.weights.sum());
+            return fit;
+        }
+
+        // Row-major 3x3 matrix that maps (p - PointO) to (s, t, h), where the point is inside the box for s and t in
+        // [0, 1] and h in [minExtent, maxExtent]. The rows are the dual basis of OA, OB and the unit normal, i.e. the
+        // inverse of the matrix with these as columns, so that a sheared base is handled as well as a rectangular one.
+        std::array<float, 9> roiBoxAxes(const ROIBox &box)
+        {
+            const Eigen::Vector3f origin{ box.pointO.x, box.pointO.y, box.pointO.z };
+            const Eigen::Vector3f oa = Eigen::Vector3f{ box.pointA.x, box.pointA.y, box.pointA.z } - origin;
+            const Eigen::Vector3f ob = Eigen::Vector3f{ box.pointB.x, box.pointB.y, box.pointB.z } - origin;
+            const Eigen::Vector3f normal = oa.cross(ob);
+            if(!(normal.squaredNorm() > 0.F))
+            {
+                throw std::invalid_argument("ROI box points O, A and B must not be collinear");
+            }
+
+            Eigen::Matrix3f basis;
+            basis << oa, ob, normal.normalized();
+            const Eigen::Matrix3f dual = basis.inverse();
+            return { { dual(0, 0),
+                       dual(0, 1),
+                       dual(0, 2),
+                       dual(1, 0),
+                       dual(1, 1),
+                       dual(1, 2),
+                       dual(2, 0),
+                       dual(2, 1),
+                       dual(2, 2) } };
+        }
+    } // namespace
+
+    Eigen::Affine3f zividToEigen(const Zivid::Matrix4x4 &zividMatrix)
+    {
+        Eigen::Matrix4f eigenMatrix;
+        for(std::size_t row = 0; row < Zivid::Matrix4x4::rows; row++)
+        {
+            for(std::size_t column = 0; column < Zivid::Matrix4x4::cols; column++)
+            {
+                eigenMatrix(row, column) = zividMatrix(row, column);
+            }
+        }
+        Eigen::Affine3f eigenTransform{ eigenMatrix };
+        return eigenTransform;
+    }
+
+    Zivid::Matrix4x4 eigenToZivid(const Eigen::Affine3f &eigenTransform)
+    {
+        Eigen::Matrix4f eigenMatrix = eigenTransform.matrix();
+        Zivid::Matrix4x4 zividMatrix;
+        for(Eigen::Index row = 0; row < eigenMatrix.rows(); row++)
+        {
+            for(Eigen::Index column = 0; column < eigenMatrix.cols(); column++)
+            {
+                zividMatrix(row, column) = eigenMatrix(row, column);
+            }
+        }
+        return zividMatrix;
+    }
+
+    PointsSoA toSoA(const std::vector<Zivid::PointXYZ> &points)
+    {
+        PointsSoA soa(static_cast<Eigen::Index>(points.size()), 3);
+        for(Eigen::Index i = 0; i < soa.rows(); i++)
+        {
+            const auto &point = points[static_cast<size_t>(i)];
+            soa(i, 0) = point.x;
+            soa(i, 1) = point.y;
+            soa(i, 2) = point.z;
+        }
+        return soa;
+    }
+
+    std::vector<Zivid::PointXYZ> toZividPoints(const PointsSoA &points)
+    {
+        std::vector<Zivid::PointXYZ> zividPoints(static_cast<size_t>(points.rows()));
+        for(Eigen::Index i = 0; i < points.rows(); i++)
+        {
+            auto &point = zividPoints[static_cast<size_t>(i)];
+            point.x = points(i, 0);
+            point.y = points(i, 1);
+            point.z = points(i, 2);
+        }
+        return zividPoints;
+    }
+
+    PointsSoA transformPoints(const PointsSoA &points, const Eigen::Affine3f &transform)
+    {
+        const Eigen::Matrix3f rotation = transform.linear();
+        const Eigen::Vector3f translation = transform.translation();
+        PointsSoA transformed(points.rows(), 3);
+        for(Eigen::Index row = 0; row < 3; row++)
+        {
+            transformed.col(row).array() = rotation(row, 0) * points.col(0).array()
+                                           + rotation(row, 1) * points.col(1).array()
+                                           + rotation(row, 2) * points.col(2).array() + translation(row);
+        }
+        return transformed;
+    }
+
+    std::vector<Zivid::PointXYZ> transformPoints(
+        const std::vector<Zivid::PointXYZ> &points,
+        const Zivid::Matrix4x4 &transform)
+    {
+        const Eigen::Affine3f eigenTransform = zividToEigen(transform);
+        std::vector<Zivid::PointXYZ> transformed(points.size());
+        for(size_t i = 0; i < points.size(); i++)
+        {
+            const Eigen::Vector3f point = eigenTransform * Eigen::Vector3f{ points[i].x, points[i].y, points[i].z };
+            transformed[i] = Zivid::PointXYZ{ point.x(), point.y(), point.z() };
+        }
+        return transformed;
+    }
+
+    Eigen::Matrix2Xf markerCenters(const MarkerCorners &corners)
+    {
+        // The diagonals are c0 + t * (c2 - c0) and c1 + s * (c3 - c1). Solving for their intersection with 2D cross
+        // products handles vertical diagonals, and is evaluated for all markers at once.
+        const Eigen::ArrayXf diagonal0U = (corners.u.row(2) - corners.u.row(0)).array();
+        const Eigen::ArrayXf diagonal0V = (corners.v.row(2) - corners.v.row(0)).array();
+        const Eigen::ArrayXf diagonal1U = (corners.u.row(3) - corners.u.row(1)).array();
+        const Eigen::ArrayXf diagonal1V = (corners.v.row(3) - corners.v.row(1)).array();
+        const Eigen::ArrayXf offsetU = (corners.u.row(1) - corners.u.row(0)).array();
+        const Eigen::ArrayXf offsetV = (corners.v.row(1) - corners.v.row(0)).array();
+        const Eigen::ArrayXf t =
+            (offsetU * diagonal1V - offsetV * diagonal1U) / (diagonal0U * diagonal1V - diagonal0V * diagonal1U);
+
+        Eigen::Matrix2Xf centers(2, corners.u.cols());
+        centers.row(0) = corners.u.row(0).array() + t.transpose() * diagonal0U.transpose();
+        centers.row(1) = corners.v.row(0).array() + t.transpose() * diagonal0V.transpose();
+        return centers;
+    }
+
+    BoardPoseEstimate estimateBoardPose(
+        const Zivid::PointXYZ *points,
+        const size_t width,
+        const size_t height,
+        const MarkerCorners &corners,
+        const MarkerAxisCorners &axisCorners)
+    {
+        const Eigen::Index minNumberOfSamples = 10;
+        const auto centers = markerCenters(corners);
+
+        BoardPoseEstimate estimate;
+        Eigen::Vector3f origin = Eigen::Vector3f::Zero();
+        Eigen::Vector3f normalSum = Eigen::Vector3f::Zero();
+        Eigen::Vector3f xAxisSum = Eigen::Vector3f::Zero();
+        for(Eigen::Index marker = 0; marker < corners.u.cols(); marker++)
+        {
+            const auto samples = markerSamples(points, width, height, corners, marker);
+            if(samples.points.cols() < minNumberOfSamples)
+            {
+                continue;
+            }
+
+            const auto plane = fitPlane(samples.points);
+
+            // Weighted least squares for the 3x3 matrix that maps (u, v, 1) to (x, y, z)
+            const Eigen::Matrix3Xf weightedPixels = samples.pixels * plane.weights.asDiagonal();
+            const Eigen::Matrix3f normalMatrix = weightedPixels * samples.pixels.transpose();
+            const Eigen::Matrix3f pixelToPoint =
+                normalMatrix.ldlt().solve(weightedPixels * samples.points.transpose()).transpose();
+
+            // The four corners and the center of the marker are mapped to 3D and projected onto the plane together
+            Eigen::Matrix<float, 3, 5> pixels;
+            pixels.row(0) << corners.u.col(marker).transpose(), centers(0, marker);
+            pixels.row(1) << corners.v.col(marker).transpose(), centers(1, marker);
+            pixels.row(2).setOnes();
+            Eigen::Matrix<float, 3, 5> onPlane = pixelToPoint * pixels;
+            onPlane -= plane.normal * (plane.normal.transpose() * (onPlane.colwise() - plane.centroid));
+
+            const Eigen::Vector3f xAxis =
+                (onPlane.col(axisCorners.xEnd) - onPlane.col(axisCorners.xBegin)).normalized();
+            const Eigen::Vector3f yAxis =
+                (onPlane.col(axisCorners.yEnd) - onPlane.col(axisCorners.yBegin)).normalized();
+            // The eigenvector sign is arbitrary, so the normal is flipped to follow the marker's corner order
+            const Eigen::Vector3f normal =
+                plane.normal.dot(xAxis.cross(yAxis)) < 0.F ? Eigen::Vector3f{ -plane.normal } : plane.normal;
+            const auto weight = static_cast<float>(samples.points.cols());
+            normalSum += weight * normal;
+            xAxisSum += weight * xAxis;
+            if(estimate.rmsResiduals.empty())
+            {
+                origin = onPlane.col(4);
+            }
+            estimate.rmsResiduals.push_back(plane.rmsResidual);
+        }
+
+        if(estimate.rmsResiduals.empty())
+        {
+            throw std::runtime_error("None of the detected markers have enough valid points");
+        }
+
+        Eigen::Affine3f pose = Eigen::Affine3f::Identity();
+        const Eigen::Vector3f zAxis = normalSum.normalized();
+        const Eigen::Vector3f xAxis = (xAxisSum - zAxis * zAxis.dot(xAxisSum)).normalized();
+        pose.linear().col(0) = xAxis;
+        pose.linear().col(1) = zAxis.cross(xAxis);
+        pose.linear().col(2) = zAxis;
+        pose.translation() = origin;
+        estimate.pose = eigenToZivid(pose);
+        return estimate;
+    }
+
+    std::vector<Zivid::PointXYZColorRGBA> roiBoxFilter(
+        std::vector<Zivid::PointXYZColorRGBA> points,
+        const size_t width,
+        const ROIBox &box,
+        const PixelRange &pixelRange,
+        const ROIFilterOutput output)
+    {
+        const auto height = width > 0 ? points.size() / width : 0;
+        if(pixelRange.beginRow > pixelRange.endRow || pixelRange.endRow > height
+           || pixelRange.beginColumn > pixelRange.endColumn || pixelRange.endColumn > width)
+        {
+            throw std::invalid_argument("Pixel range must be inside the point cloud");
+        }
+        const auto axes = roiBoxAxes(box);
+
+        const auto setToNaN = [&points](const size_t begin, const size_t end) {
+            for(size_t i = begin; i < end; i++)
+            {
+                points[i].point.x = std::numeric_limits<float>::quiet_NaN();
+                points[i].point.y = std::numeric_limits<float>::quiet_NaN();
+                points[i].point.z = std::numeric_limits<float>::quiet_NaN();
+            }
+        };
+
+        const auto beginColumn = pixelRange.beginColumn;
+        const auto endColumn = pixelRange.endColumn;
+        const auto filterRows = [&](const size_t beginRow, const size_t endRow) {
+            std::vector<Zivid::PointXYZColorRGBA> inside;
+            for(size_t row = beginRow; row < endRow; row++)
+            {
+                for(size_t i = row * width + beginColumn; i < row * width + endColumn; i++)
+                {
+                    auto &p = points[i];
+                    const auto x = p.point.x - box.pointO.x;
+                    const auto y = p.point.y - box.pointO.y;
+                    const auto z = p.point.z - box.pointO.z;
+                    const auto s = axes[0] * x + axes[1] * y + axes[2] * z;
+                    const auto t = axes[3] * x + axes[4] * y + axes[5] * z;
+                    const auto h = axes[6] * x + axes[7] * y + axes[8] * z;
+                    // Comparisons with NaN are false, so NaN points are never inside
+                    const auto isInside = s >= 0.F && s <= 1.F && t >= 0.F && t <= 1.F && h >= box.minExtent
+                                          && h <= box.maxExtent;
+                    if(output == ROIFilterOutput::compacted)
+                    {
+                        if(isInside)
+                        {
+                            inside.push_back(p);
+                        }
+                    }
+                    else if(!isInside)
+                    {
+                        setToNaN(i, i + 1);
+                    }
+                }
+                if(output == ROIFilterOutput::organized)
+                {
+                    setToNaN(row * width, row * width + beginColumn);
+                    setToNaN(row * width + endColumn, (row + 1) * width);
+                }
+            }
+            return inside;
+        };
+
+        const auto beginRow = pixelRange.beginRow;
+        const auto endRow = pixelRange.endRow;
+        if(output == ROIFilterOutput::organized)
+        {
+            setToNaN(0, beginRow * width);
+            setToNaN(endRow * width, points.size());
+        }
+
+        const auto numberOfRows = endRow - beginRow;
+        const auto numberOfWorkers =
+            std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), numberOfRows));
+        const auto rowsPerWorker = std::max<size_t>(1, (numberOfRows + numberOfWorkers - 1) / numberOfWorkers);
+        std::vector<std::future<std::vector<Zivid::PointXYZColorRGBA>>> futures;
+        for(size_t row = beginRow; row < endRow; row += rowsPerWorker)
+        {
+            futures.push_back(
+                std::async(std::launch::async, filterRows, row, std::min(row + rowsPerWorker, endRow)));
+        }
+
+        std::vector<Zivid::PointXYZColorRGBA> compacted;
+        for(auto &future : futures)
+        {
+            const auto inside = future.get();
+            compacted.insert(compacted.end(), inside.begin(), inside.end());
+        }
+
+        // Separate returns, so that the returned vector is moved instead of copied
+        if(output == ROIFilterOutput::compacted)
+        {
+            return compacted;
+        }
+        return points;
+    }
+
+    std::vector<Zivid::PointXYZColorRGBA> roiBoxFilter(
+        const Zivid::PointCloud &pointCloud,
+        const ROIBox &box,
+        const PixelRange &pixelRange,
+        const ROIFilterOutput output)
+    {
+        std::vector<Zivid::PointXYZColorRGBA> points(pointCloud.size());
+        pointCloud.copyData(points.data());
+        return roiBoxFilter(std::move(points), pointCloud.width(), box, pixelRange, output);
+    }
+
+    std::vector<Zivid::PointXYZColorRGBA>
+        roiBoxFilter(const Zivid::PointCloud &pointCloud, const ROIBox &box, const ROIFilterOutput output)
+    {
+        return roiBoxFilter(
+            pointCloud, box, PixelRange{ 0, pointCloud.height(), 0, pointCloud.width() }, output);
+    }
+
+    size_t numberOfValidPoints(const Zivid::PointCloud &pointCloud)
+    {
+        const auto points = pointCloud.copyPointsXYZ();
+        return static_cast<size_t>(
+            std::count_if(points.begin(), points.end(), [](const Zivid::PointXYZ &p) { return !p.isNaN(); }));
+    }
+} // namespace PoseEstimation
@@ -0,0 +1,153 @@
+/*
+Pose estimation and point transformation shared by the samples that locate a calibration board or an ArUco marker and
+work in its coordinate frame.
+
+Points and marker corners are passed in batches in SoA layout, so that a single call handles all points or all markers
+and Eigen can vectorize over them.
+*/
+
+#pragma once
+
+#include <Zivid/Zivid.h>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <cstddef>
+#include <vector>
+
+namespace PoseEstimation
+{
+    Eigen::Affine3f zividToEigen(const Zivid::Matrix4x4 &zividMatrix);
+
+    Zivid::Matrix4x4 eigenToZivid(const Eigen::Affine3f &eigenTransform);
+
+    // Points in SoA layout, one row per point and one column per coordinate. The matrix is column-major, so all x,
+    // all y and all z coordinates are each contiguous in memory.
+    using PointsSoA = Eigen::Matrix<float, Eigen::Dynamic, 3>;
+
+    PointsSoA toSoA(const std::vector<Zivid::PointXYZ> &points);
+
+    std::vector<Zivid::PointXYZ> toZividPoints(const PointsSoA &points);
+
+    // Each output coordinate is one vectorized expression over the contiguous input columns. This avoids the
+    // temporaries of a general matrix product, which make a mapped 3xN product slower than a loop over the points.
+    PointsSoA transformPoints(const PointsSoA &points, const Eigen::Affine3f &transform);
+
+    // Loops over the points with fixed-size Eigen types, which is as fast as the SoA version when the points are
+    // already in a std::vector, since the transform is then limited by memory bandwidth and not by arithmetic
+    std::vector<Zivid::PointXYZ> transformPoints(
+        const std::vector<Zivid::PointXYZ> &points,
+        const Zivid::Matrix4x4 &transform);
+
+    // Pixel coordinates of the corners of several markers in SoA layout, one column per marker and one row per
+    // corner, with the corners in the order that ArUco detects them
+    struct MarkerCorners
+    {
+        Eigen::Matrix4Xf u;
+        Eigen::Matrix4Xf v;
+    };
+
+    // Works with any 2D point type with x and y members, such as cv::Point2f
+    template<typename Point2D>
+    MarkerCorners toMarkerCorners(const std::vector<std::vector<Point2D>> &markerCorners)
+    {
+        const auto numberOfMarkers = static_cast<Eigen::Index>(markerCorners.size());
+        MarkerCorners corners{ Eigen::Matrix4Xf(4, numberOfMarkers), Eigen::Matrix4Xf(4, numberOfMarkers) };
+        for(Eigen::Index marker = 0; marker < numberOfMarkers; marker++)
+        {
+            const auto &markerCorner = markerCorners[static_cast<size_t>(marker)];
+            for(Eigen::Index corner = 0; corner < 4; corner++)
+            {
+                corners.u(corner, marker) = markerCorner.at(static_cast<size_t>(corner)).x;
+                corners.v(corner, marker) = markerCorner.at(static_cast<size_t>(corner)).y;
+            }
+        }
+        return corners;
+    }
+
+    // Pixel centers of all markers, one column per marker, as the intersections of the marker diagonals
+    Eigen::Matrix2Xf markerCenters(const MarkerCorners &corners);
+
+    // The pose axes run between these marker corners: x from xBegin to xEnd, and y from yBegin to yEnd
+    struct MarkerAxisCorners
+    {
+        Eigen::Index xBegin;
+        Eigen::Index xEnd;
+        Eigen::Index yBegin;
+        Eigen::Index yEnd;
+    };
+
+    struct BoardPoseEstimate
+    {
+        Zivid::Matrix4x4 pose;
+        std::vector<float> rmsResiduals;
+    };
+
+    // Estimates the pose of a board with one or more markers, all with the same orientation, from an organized point
+    // cloud. Each marker is fitted with a robust plane through all valid points inside it, and a weighted affine map
+    // from pixels to 3D points gives its corners and center even where those pixels are NaN. The origin is the center
+    // of the first marker with enough valid points, and the axes are averaged over all such markers. The RMS plane
+    // residual of each of these markers is reported.
+    BoardPoseEstimate estimateBoardPose(
+        const Zivid::PointXYZ *points,
+        size_t width,
+        size_t height,
+        const MarkerCorners &corners,
+        const MarkerAxisCorners &axisCorners);
+
+    inline BoardPoseEstimate estimateBoardPose(
+        const Zivid::Array2D<Zivid::PointXYZ> &points,
+        const MarkerCorners &corners,
+        const MarkerAxisCorners &axisCorners)
+    {
+        return estimateBoardPose(points.data(), points.width(), points.height(), corners, axisCorners);
+    }
+
+    // Same semantics as Settings::RegionOfInterest::Box: the base of the box is the parallelogram spanned by
+    // PointO->PointA and PointO->PointB, and the box extends from minExtent to maxExtent along the normal OA x OB
+    struct ROIBox
+    {
+        Zivid::PointXYZ pointO;
+        Zivid::PointXYZ pointA;
+        Zivid::PointXYZ pointB;
+        float minExtent;
+        float maxExtent;
+    };
+
+    enum class ROIFilterOutput
+    {
+        organized,
+        compacted
+    };
+
+    // Rows and columns of the point cloud that are tested against the ROI box, everything outside is treated as
+    // outside the box
+    struct PixelRange
+    {
+        size_t beginRow;
+        size_t endRow;
+        size_t beginColumn;
+        size_t endColumn;
+    };
+
+    // Applies the ROI box to an existing point cloud on the CPU, without capturing again. Organized output keeps the
+    // point cloud layout and sets the points outside the box to NaN, compacted output keeps only the points inside.
+    std::vector<Zivid::PointXYZColorRGBA> roiBoxFilter(
+        std::vector<Zivid::PointXYZColorRGBA> points,
+        size_t width,
+        const ROIBox &box,
+        const PixelRange &pixelRange,
+        ROIFilterOutput output);
+
+    std::vector<Zivid::PointXYZColorRGBA> roiBoxFilter(
+        const Zivid::PointCloud &pointCloud,
+        const ROIBox &box,
+        const PixelRange &pixelRange,
+        ROIFilterOutput output);
+
+    std::vector<Zivid::PointXYZColorRGBA>
+        roiBoxFilter(const Zivid::PointCloud &pointCloud, const ROIBox &box, ROIFilterOutput output);
+
+    size_t numberOfValidPoints(const Zivid::PointCloud &pointCloud);
+} // namespace PoseEstimation
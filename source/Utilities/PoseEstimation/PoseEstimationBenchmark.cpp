@@ -0,0 +1,248 @@
+/*
+Benchmark the batched point transforms, the board pose estimation and the ROI box filter in the PoseEstimation library
+on synthetic data with the resolution of a Zivid 2 point cloud. No camera is needed.
+
+Each benchmark also checks its result, and the program fails if any result is wrong.
+*/
+
+#include "PoseEstimation/PoseEstimation.h"
+
+#include <Zivid/Zivid.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const size_t width = 1944;
+    const size_t height = 1200;
+
+    template<typename Function>
+    double medianMilliseconds(const Function &function)
+    {
+        const size_t numberOfRepetitions = 11;
+        std::vector<double> durations;
+        for(size_t i = 0; i < numberOfRepetitions; i++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const auto stop = std::chrono::steady_clock::now();
+            durations.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+        }
+        std::sort(durations.begin(), durations.end());
+        return durations[durations.size() / 2];
+    }
+
+    void printResult(const std::string &name, const double milliseconds)
+    {
+        std::cout << "  " << std::left << std::setw(48) << name << std::right << std::setw(10) << std::fixed
+                  << std::setprecision(3) << milliseconds << " ms" << std::endl;
+    }
+
+    void check(const bool condition, const std::string &message)
+    {
+        if(!condition)
+        {
+            throw std::runtime_error("Check failed: " + message);
+        }
+    }
+
+    // Pinhole projection of a tilted plane, so that every pixel has a valid point
+    struct SyntheticScene
+    {
+        float focalLength;
+        Eigen::Vector3f planePoint;
+        Eigen::Vector3f planeNormal;
+
+        Zivid::PointXYZ pointAt(const float u, const float v) const
+        {
+            const auto cx = static_cast<float>(width) / 2.F;
+            const auto cy = static_cast<float>(height) / 2.F;
+            const Eigen::Vector3f ray{ (u - cx) / focalLength, (v - cy) / focalLength, 1.F };
+            const Eigen::Vector3f point = ray * planeNormal.dot(planePoint) / planeNormal.dot(ray);
+            return Zivid::PointXYZ{ point.x(), point.y(), point.z() };
+        }
+    };
+
+    std::vector<Zivid::PointXYZ> sceneToPoints(const SyntheticScene &scene)
+    {
+        std::vector<Zivid::PointXYZ> points;
+        points.reserve(width * height);
+        for(size_t row = 0; row < height; row++)
+        {
+            for(size_t column = 0; column < width; column++)
+            {
+                points.push_back(scene.pointAt(static_cast<float>(column), static_cast<float>(row)));
+            }
+        }
+        return points;
+    }
+
+    float maxDistance(const std::vector<Zivid::PointXYZ> &points1, const std::vector<Zivid::PointXYZ> &points2)
+    {
+        float distance = 0.F;
+        for(size_t i = 0; i < points1.size(); i++)
+        {
+            distance = std::max(
+                distance,
+                std::abs(points1[i].x - points2[i].x) + std::abs(points1[i].y - points2[i].y)
+                    + std::abs(points1[i].z - points2[i].z));
+        }
+        return distance;
+    }
+
+    void benchmarkTransformPoints(const std::vector<Zivid::PointXYZ> &points)
+    {
+        std::cout << "Transforming " << points.size() << " points" << std::endl;
+        const Eigen::Affine3f transform = Eigen::Translation3f{ 10.F, -20.F, 30.F }
+                                          * Eigen::AngleAxisf{ 0.3F, Eigen::Vector3f{ 1.F, 2.F, 3.F }.normalized() };
+        const auto zividTransform = PoseEstimation::eigenToZivid(transform);
+
+        std::vector<Zivid::PointXYZ> perPoint;
+        printResult("Per point (std::vector<Zivid::PointXYZ>)", medianMilliseconds([&] {
+                        perPoint = PoseEstimation::transformPoints(points, zividTransform);
+                    }));
+
+        // The general matrix product on a mapped 3xN matrix, which the ROI samples used before this library
+        std::vector<Zivid::PointXYZ> mapped(points.size());
+        const auto numberOfPoints = static_cast<Eigen::Index>(points.size());
+        printResult("Mapped 3xN matrix product", medianMilliseconds([&] {
+                        const Eigen::Map<const Eigen::Matrix3Xf> input(
+                            reinterpret_cast<const float *>(points.data()), 3, numberOfPoints);
+                        Eigen::Map<Eigen::Matrix3Xf> output(
+                            reinterpret_cast<float *>(mapped.data()), 3, numberOfPoints);
+                        output = (transform.linear() * input).colwise() + transform.translation();
+                    }));
+
+        const auto soa = PoseEstimation::toSoA(points);
+        PoseEstimation::PointsSoA transformedSoA;
+        printResult("SoA (PointsSoA)", medianMilliseconds([&] {
+                        transformedSoA = PoseEstimation::transformPoints(soa, transform);
+                    }));
+
+        check(maxDistance(perPoint, mapped) < 1e-3F, "Mapped transform differs from the per point transform");
+        check(
+            maxDistance(perPoint, PoseEstimation::toZividPoints(transformedSoA)) < 1e-3F,
+            "SoA transform differs from the per point transform");
+    }
+
+    // Markers are squares in the image with the corners in ArUco order: top-left, top-right, bottom-right, bottom-left
+    PoseEstimation::MarkerCorners markerGrid(const size_t numberOfMarkers)
+    {
+        const float markerSize = 80.F;
+        const float spacing = 120.F;
+        std::vector<std::vector<Eigen::Vector2f>> markers;
+        for(size_t i = 0; i < numberOfMarkers; i++)
+        {
+            const Eigen::Vector2f topLeft{ 400.F + spacing * static_cast<float>(i % 8),
+                                           300.F + spacing * static_cast<float>(i / 8) };
+            markers.push_back({ topLeft,
+                                topLeft + Eigen::Vector2f{ markerSize, 0.F },
+                                topLeft + Eigen::Vector2f{ markerSize, markerSize },
+                                topLeft + Eigen::Vector2f{ 0.F, markerSize } });
+        }
+
+        PoseEstimation::MarkerCorners corners{ Eigen::Matrix4Xf(4, static_cast<Eigen::Index>(numberOfMarkers)),
+                                               Eigen::Matrix4Xf(4, static_cast<Eigen::Index>(numberOfMarkers)) };
+        for(Eigen::Index marker = 0; marker < corners.u.cols(); marker++)
+        {
+            for(Eigen::Index corner = 0; corner < 4; corner++)
+            {
+                const auto &pixel = markers[static_cast<size_t>(marker)][static_cast<size_t>(corner)];
+                corners.u(corner, marker) = pixel.x();
+                corners.v(corner, marker) = pixel.y();
+            }
+        }
+        return corners;
+    }
+
+    void benchmarkBoardPose(const SyntheticScene &scene, const std::vector<Zivid::PointXYZ> &points)
+    {
+        for(const auto numberOfMarkers : { size_t{ 1 }, size_t{ 4 }, size_t{ 16 } })
+        {
+            std::cout << "Estimating board pose from " << numberOfMarkers << " markers" << std::endl;
+            const auto corners = markerGrid(numberOfMarkers);
+
+            PoseEstimation::BoardPoseEstimate estimate;
+            printResult("estimateBoardPose", medianMilliseconds([&] {
+                            estimate = PoseEstimation::estimateBoardPose(
+                                points.data(), width, height, corners, PoseEstimation::MarkerAxisCorners{ 0, 1, 1, 2 });
+                        }));
+
+            // With x along the top edge and y along the right edge, the normal points away from the camera
+            const Eigen::Affine3f pose = PoseEstimation::zividToEigen(estimate.pose);
+            const Eigen::Vector3f expectedNormal = scene.planeNormal.normalized();
+            const auto centers = PoseEstimation::markerCenters(corners);
+            const auto expectedOrigin = scene.pointAt(centers(0, 0), centers(1, 0));
+            check(pose.linear().col(2).dot(expectedNormal) > std::cos(0.001F), "Board normal is wrong");
+            check(
+                (pose.translation() - Eigen::Vector3f{ expectedOrigin.x, expectedOrigin.y, expectedOrigin.z }).norm()
+                    < 0.5F,
+                "Board origin is wrong");
+            check(estimate.rmsResiduals.size() == numberOfMarkers, "Not all markers were used");
+        }
+    }
+
+    void benchmarkROIBoxFilter(const std::vector<Zivid::PointXYZ> &points)
+    {
+        std::cout << "Filtering " << points.size() << " points with an ROI box" << std::endl;
+        std::vector<Zivid::PointXYZColorRGBA> coloredPoints(points.size());
+        for(size_t i = 0; i < points.size(); i++)
+        {
+            coloredPoints[i].point = points[i];
+        }
+
+        // A box around the part of the plane seen in the center quarter of the image
+        const auto &center = points[(height / 2) * width + width / 2];
+        const auto &right = points[(height / 2) * width + width * 5 / 8];
+        const auto &down = points[(height * 5 / 8) * width + width / 2];
+        const PoseEstimation::ROIBox box{ center, right, down, -50.F, 50.F };
+
+        const PoseEstimation::PixelRange fullRange{ 0, height, 0, width };
+        // Generous margin around the pixels of the box corners, since the synthetic scene has a perspective projection
+        const PoseEstimation::PixelRange restrictedRange{
+            height / 2 - 50, height * 3 / 4, width / 2 - 50, width * 3 / 4
+        };
+        std::vector<Zivid::PointXYZColorRGBA> fullResult;
+        std::vector<Zivid::PointXYZColorRGBA> restrictedResult;
+        printResult("Full image", medianMilliseconds([&] {
+                        fullResult = PoseEstimation::roiBoxFilter(
+                            coloredPoints, width, box, fullRange, PoseEstimation::ROIFilterOutput::compacted);
+                    }));
+        printResult("Projected box rectangle", medianMilliseconds([&] {
+                        restrictedResult = PoseEstimation::roiBoxFilter(
+                            coloredPoints, width, box, restrictedRange, PoseEstimation::ROIFilterOutput::compacted);
+                    }));
+
+        check(!fullResult.empty(), "No points inside the ROI box");
+        check(
+            fullResult.size() == restrictedResult.size(),
+            "The restricted pixel range gives a different number of points than the full image");
+    }
+} // namespace
+
+int main()
+{
+    try
+    {
+        const SyntheticScene scene{ 1700.F, Eigen::Vector3f{ 0.F, 0.F, 800.F }, Eigen::Vector3f{ 0.2F, -0.3F, 1.F } };
+        const auto points = sceneToPoints(scene);
+
+        benchmarkTransformPoints(points);
+        benchmarkBoardPose(scene, points);
+        benchmarkROIBoxFilter(points);
+    }
+    catch(const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}